@@ -0,0 +1,257 @@
+/*
+ * Dijkstra benchmark
+ * https://github.com/lano1106/indirect_heap
+ *
+ * single source shortest paths with decrease-key in
+ * Base::VertexPriorityQueue (keys inline in the heap array) and
+ * Base::IndexedPriorityQueue (keys in a side array), against a
+ * std::priority_queue with lazy deletion, which pushes a vertex again each
+ * time its distance improves and skips the stale entries when they are
+ * popped.
+ *
+ * Two synthetic graphs are searched from the same random sources:
+ *
+ * road:  W x W grid, 4 neighbours, random travel times. (road networks
+ *        are near planar with a low degree)
+ * dense: random graph with 32 out edges per vertex.
+ *
+ * with uint32_t and double distances. The time, the number of pushes and
+ * the largest heap size are reported per search. The distances of every
+ * queue are checked against the lazy deletion search.
+ *
+ * to compile:
+ * g++ -std=c++26 -O2 -DNDEBUG dijkstra_bench.cpp
+ *
+ * usage:
+ * dijkstra_bench [grid width (default 1000)] [dense vertices (default 200000)]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+#include "priority_queue_indexed.h"
+
+namespace {
+
+constexpr int Sources    = 4;
+constexpr int DenseEdges = 32;
+
+/*
+ * compressed sparse rows graph
+ */
+struct Graph
+{
+    std::vector<std::uint32_t> first; // first edge of every vertex, plus the end
+    std::vector<std::uint32_t> to;
+    std::vector<std::uint32_t> weight;
+
+    std::uint32_t vertices() const noexcept
+    {
+        return static_cast<std::uint32_t>(first.size() - 1);
+    }
+};
+
+Graph makeRoadGraph(std::uint32_t width, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<std::uint32_t> travel(100, 999);
+    Graph g;
+
+    g.first.reserve(size_t{width} * width + 1);
+    for (std::uint32_t y{}; y < width; ++y) {
+        for (std::uint32_t x{}; x < width; ++x) {
+            const std::uint32_t v{y * width + x};
+
+            g.first.push_back(static_cast<std::uint32_t>(g.to.size()));
+            if (x > 0)
+                g.to.push_back(v - 1);
+            if (x + 1 < width)
+                g.to.push_back(v + 1);
+            if (y > 0)
+                g.to.push_back(v - width);
+            if (y + 1 < width)
+                g.to.push_back(v + width);
+        }
+    }
+    g.first.push_back(static_cast<std::uint32_t>(g.to.size()));
+    g.weight.resize(g.to.size());
+    for (auto &w : g.weight)
+        w = travel(rng);
+    return g;
+}
+
+Graph makeDenseGraph(std::uint32_t n, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<std::uint32_t> vertex(0, n - 1);
+    std::uniform_int_distribution<std::uint32_t> cost(1, 100000);
+    Graph g;
+
+    g.first.reserve(size_t{n} + 1);
+    g.to.reserve(size_t{n} * DenseEdges);
+    for (std::uint32_t v{}; v < n; ++v) {
+        g.first.push_back(static_cast<std::uint32_t>(g.to.size()));
+        for (int i{}; i < DenseEdges; ++i)
+            g.to.push_back(vertex(rng));
+    }
+    g.first.push_back(static_cast<std::uint32_t>(g.to.size()));
+    g.weight.resize(g.to.size());
+    for (auto &w : g.weight)
+        w = cost(rng);
+    return g;
+}
+
+struct Result
+{
+    double ms{};
+    size_t pushes{};
+    size_t maxSize{};
+};
+
+template <typename Key>
+Result lazyDijkstra(const Graph &g, std::uint32_t source, std::vector<Key> &dist)
+{
+    using Entry = std::pair<Key, std::uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > q;
+    Result r;
+    const auto t0{std::chrono::steady_clock::now()};
+
+    dist.assign(g.vertices(), std::numeric_limits<Key>::max());
+    dist[source] = Key{};
+    q.push({Key{}, source});
+    ++r.pushes;
+    while (!q.empty()) {
+        const auto [d, u]{q.top()};
+
+        q.pop();
+        if (d > dist[u])
+            continue; // stale
+        for (auto e{g.first[u]}; e < g.first[u + 1]; ++e) {
+            const Key nd{d + static_cast<Key>(g.weight[e])};
+            const auto v{g.to[e]};
+
+            if (nd < dist[v]) {
+                dist[v] = nd;
+                q.push({nd, v});
+                ++r.pushes;
+                r.maxSize = std::max(r.maxSize, q.size());
+            }
+        }
+    }
+    r.ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+    return r;
+}
+
+/*
+ * Queue is Base::VertexPriorityQueue or Base::IndexedPriorityQueue with
+ * the lowest key on top.
+ */
+template <typename Queue, typename Key>
+Result indexedDijkstra(const Graph &g, std::uint32_t source, std::vector<Key> &dist)
+{
+    Queue  q(g.vertices());
+    Result r;
+    const auto t0{std::chrono::steady_clock::now()};
+
+    dist.assign(g.vertices(), std::numeric_limits<Key>::max());
+    dist[source] = Key{};
+    q.push(source, Key{});
+    ++r.pushes;
+    while (!q.empty()) {
+        const auto u{q.top()};
+        const Key  d{q.top_key()};
+
+        q.pop();
+        for (auto e{g.first[u]}; e < g.first[u + 1]; ++e) {
+            const Key nd{d + static_cast<Key>(g.weight[e])};
+            const auto v{g.to[e]};
+
+            if (nd < dist[v]) {
+                dist[v] = nd;
+                if (q.contains(v)) {
+                    q.decrease_key(v, nd);
+                }
+                else {
+                    q.push(v, nd);
+                    ++r.pushes;
+                    r.maxSize = std::max(r.maxSize, q.size());
+                }
+            }
+        }
+    }
+    r.ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+    return r;
+}
+
+void print(const char *name, const Result &r)
+{
+    std::printf("  %-28s %9.2f ms %10zu pushes %9zu max size\n", name,
+                r.ms / Sources, r.pushes / Sources, r.maxSize);
+}
+
+void accumulate(Result &total, const Result &r)
+{
+    total.ms     += r.ms;
+    total.pushes += r.pushes;
+    total.maxSize = std::max(total.maxSize, r.maxSize);
+}
+
+template <typename Key>
+void run(const char *keyName, const Graph &g, const std::uint32_t *sources)
+{
+    using VertexQueue  = Base::VertexPriorityQueue<Key>;
+    using IndexedQueue = Base::IndexedPriorityQueue<Key, std::greater<Key> >;
+    std::vector<Key> expected;
+    std::vector<Key> dist;
+    Result lazy, vertex, indexed;
+    bool   ok{true};
+
+    for (int i{}; i < Sources; ++i) {
+        accumulate(lazy, lazyDijkstra(g, sources[i], expected));
+        accumulate(vertex,
+                   indexedDijkstra<VertexQueue>(g, sources[i], dist));
+        ok = ok && dist == expected;
+        accumulate(indexed,
+                   indexedDijkstra<IndexedQueue>(g, sources[i], dist));
+        ok = ok && dist == expected;
+    }
+    std::printf(" %s distances%s\n", keyName, ok ? "" : " (MISMATCH)");
+    print("std::priority_queue lazy", lazy);
+    print("Base::VertexPriorityQueue", vertex);
+    print("Base::IndexedPriorityQueue", indexed);
+}
+
+void runGraph(const char *name, const Graph &g, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<std::uint32_t> vertex(0, g.vertices() - 1);
+    std::uint32_t sources[Sources];
+
+    for (auto &s : sources)
+        s = vertex(rng);
+    std::printf("%s graph: %u vertices, %zu edges, per search:\n", name,
+                g.vertices(), g.to.size());
+    run<std::uint32_t>("uint32_t", g, sources);
+    run<double>("double", g, sources);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    const auto width{argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10))
+                              : 1000u};
+    const auto dense{argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10))
+                              : 200000u};
+    std::mt19937 rng(42);
+
+    runGraph("road", makeRoadGraph(width, rng), rng);
+    runGraph("dense", makeDenseGraph(dense, rng), rng);
+    return 0;
+}
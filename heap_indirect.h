@@ -14,225 +14,3694 @@
  * Olivier Langlois - July 11, 2024
  */
 
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * the bottom-up sift used to be selected for the whole program by defining
+ * this macro. Pass Base::bottom_up_policy to the algorithms that need it
+ * instead. Neither sift keeps the elements of equal priority in insertion
+ * order, compare them with Base::fifo_compare for that.
+ */
+#ifdef BASE_HEAP_PRESERVE_STABILITY
+#error "BASE_HEAP_PRESERVE_STABILITY is replaced by Base::bottom_up_policy and Base::fifo_compare"
+#endif
+
+namespace Base {
+
+/*
+ * strategies to fix the heap condition below an element whose priority
+ * has been lowered, ie: when the last element replaces the popped one.
+ *
+ * top_down_sift:  classic sift that stops as soon as the element is in
+ *                 place. 2 comparisons per level.
+ * bottom_up_sift: Wegener bottom-up sift. Descends to a leaf with 1
+ *                 comparison per level and sifts the element back up.
+ *                 Cuts the comparisons by nearly half when comparisons are
+ *                 expensive (ie: when comp dereferences cold objects).
+ *
+ * Heaps are not stable whatever the sift: elements of equal priority come
+ * out in no particular order. (see Base::fifo_compare)
+ */
+struct top_down_sift {};
+struct bottom_up_sift {};
+
+/*
+ * heap operations reported to the instrumentation hooks
+ */
+enum class heap_op { push, pop, erase, update, make, replace };
+
+/*
+ * heap policies
+ *
+ * compile-time options of the heap algorithms, passed as their last
+ * argument so that every heap instance only pays for what it needs:
+ *
+ * Base::pop_heap(first, last, comp, Base::bottom_up_policy{});
+ *
+ * Calls without a policy use Base::default_policy. Custom policies can be
+ * derived from heap_policy.
+ *
+ * top_down_policy:  fastest, top-down sift.
+ * bottom_up_policy: bottom-up sift, the best choice when comparisons are
+ *                   expensive.
+ */
+template <typename Sift>
+struct heap_policy
+{
+    using sift_strategy = Sift;
+
+    /*
+     * instrumentation hooks called by the algorithms. They do nothing and
+     * compile to nothing. (see Base::instrumented_policy)
+     *
+     * when instrumented is true, the comparisons are counted by wrapping
+     * the comparison functor.
+     */
+    static constexpr bool instrumented = false;
+
+    constexpr void beginOp(heap_op) noexcept {}
+    constexpr void endOp() noexcept {}
+    constexpr void onCompare() noexcept {}
+    constexpr void onMove() noexcept {}
+    constexpr void onSetHeapIndex() noexcept {}
+    constexpr void onLevel() noexcept {}
+};
+
+using top_down_policy  = heap_policy<top_down_sift>;
+using bottom_up_policy = heap_policy<bottom_up_sift>;
+using default_policy   = top_down_policy;
+
+template <typename Policy>
+concept HeapPolicy = requires (Policy &p) {
+    typename Policy::sift_strategy;
+    { Policy::instrumented } -> std::convertible_to<bool>;
+    p.beginOp(heap_op::push);
+    p.endOp();
+    p.onCompare();
+    p.onMove();
+    p.onSetHeapIndex();
+    p.onLevel();
+};
+
+/*
+ * cost of a single heap operation
+ *
+ * compares:      comparison functor calls
+ * moves:         elements stored in a heap slot
+ * index_updates: setHeapIndex() calls
+ * levels:        heap levels visited by the sifts
+ */
+struct heap_op_stats
+{
+    heap_op     op;
+    std::size_t compares;
+    std::size_t moves;
+    std::size_t index_updates;
+    std::size_t levels;
+};
+
+/*
+ * instrumented heap policy
+ *
+ * counts the cost of every heap operation and reports it to the observer
+ * when the operation completes:
+ *
+ * void Observer::operator()(const Base::heap_op_stats &);
+ *
+ * ie: to feed a depth histogram per heap. Base::heap_counters sums them.
+ *
+ * The observer is referenced, not copied, since the algorithms take the
+ * policy by value. The comparisons are made through a counting wrapper
+ * of the comparison functor, which disables the vectorized d-ary child
+ * selection. The moves done inside std::make_heap() by Base::make_heap()
+ * are not counted.
+ */
+template <typename Observer, typename Sift = top_down_sift>
+struct instrumented_policy : heap_policy<Sift>
+{
+    static constexpr bool instrumented = true;
+
+    Observer     *observer;
+    heap_op_stats stats{};
+
+    explicit constexpr instrumented_policy(Observer &o) noexcept
+    : observer(&o) {}
+
+    constexpr void beginOp(heap_op op) noexcept { stats = {op, 0, 0, 0, 0}; }
+    constexpr void endOp() { (*observer)(std::as_const(stats)); }
+    constexpr void onCompare() noexcept { ++stats.compares; }
+    constexpr void onMove() noexcept { ++stats.moves; }
+    constexpr void onSetHeapIndex() noexcept { ++stats.index_updates; }
+    constexpr void onLevel() noexcept { ++stats.levels; }
+};
+
+/*
+ * instrumented_policy observer summing the cost of all the operations
+ */
+struct heap_counters
+{
+    std::size_t ops{};
+    std::size_t compares{};
+    std::size_t moves{};
+    std::size_t index_updates{};
+    std::size_t levels{};
+    std::size_t max_levels{};
+
+    constexpr void operator()(const heap_op_stats &s) noexcept
+    {
+        ++ops;
+        compares      += s.compares;
+        moves         += s.moves;
+        index_updates += s.index_updates;
+        levels        += s.levels;
+        max_levels     = std::max(max_levels, s.levels);
+    }
+};
+
+/*
+ * handle table heap policy
+ *
+ * for heaps of dense integer ids whose elements cannot hold their
+ * position: the position of id is written to positions[id] instead of
+ * calling setHeapIndex(). Combine with id_compare to keep the keys in a
+ * side array indexed by id. (see Base::IndexedPriorityQueue)
+ *
+ * The heap elements are either the ids or carry one in their id member.
+ * (see Base::keyed_id)
+ *
+ * Policy is the policy extended with the handle table.
+ */
+template <typename Policy = default_policy, typename Index = std::uint32_t>
+struct handle_table_policy : Policy
+{
+    Index *positions;
+
+    explicit constexpr handle_table_policy(Index *p,
+                                           const Policy &policy = Policy())
+    : Policy(policy), positions(p) {}
+
+    template <typename T, typename Distance>
+    constexpr void recordHeapIndex(const T &e, Distance k) noexcept
+    {
+        if constexpr (std::is_integral_v<T>)
+            positions[e] = static_cast<Index>(k);
+        else
+            positions[e.id] = static_cast<Index>(k);
+    }
+
+    template <typename T>
+    constexpr Index heapIndex(const T &e) const noexcept
+    {
+        if constexpr (std::is_integral_v<T>)
+            return positions[e];
+        else
+            return positions[e.id];
+    }
+};
+
+/*
+ * prefetching heap policy
+ *
+ * once a heap outgrows the caches, every level of a sift waits for the
+ * slots of the children and, for pointer elements, for the objects that
+ * the comparisons dereference. While the children of a node are compared,
+ * this policy prefetches:
+ *
+ * - the slots of the grandchildren of the children, 2 levels ahead.
+ * - the objects pointed by the grandchildren, 1 level ahead, when the
+ *   elements are pointers or pointer-like (ie: Base::hook_ptr). Their
+ *   slots were prefetched at the previous level.
+ *
+ * so that the misses of consecutive levels overlap. It can only pay off on
+ * heaps far out of the last level cache and the gain depends on the
+ * memory system: measure it with heap_indirect_bench, "Base heap
+ * (prefetch)". Only the binary downheap prefetches.
+ *
+ * Policy is the policy extended with the prefetches.
+ */
+template <typename Policy = default_policy>
+struct prefetch_policy : Policy
+{
+    constexpr prefetch_policy() = default;
+    explicit constexpr prefetch_policy(const Policy &policy) : Policy(policy) {}
+
+    /*
+     * called before comparing the children secondChild - 1 and secondChild
+     */
+    template <typename RandomAccessIterator, typename Distance>
+    constexpr void prefetch(RandomAccessIterator first, Distance secondChild,
+                            Distance len) const noexcept
+    {
+#if defined(__GNUC__)
+        using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
+
+        if (std::is_constant_evaluated())
+            return;
+
+        // the 8 slots below the grandchildren span 1 or 2 cache lines
+        const Distance slots{4 * secondChild - 1};
+
+        if (slots < len) {
+            __builtin_prefetch(std::addressof(*(first + slots)));
+            __builtin_prefetch(std::addressof(*(first + std::min(slots + 7, len - 1))));
+        }
+        if constexpr (std::is_pointer_v<ValueType> ||
+                      requires (const ValueType &v) { v.operator->(); }) {
+            const Distance grandchild{2 * secondChild - 1};
+            const Distance end{std::min(grandchild + 4, len)};
+
+            for (Distance g{grandchild}; g < end; ++g) {
+                if constexpr (std::is_pointer_v<ValueType>)
+                    __builtin_prefetch(*(first + g));
+                else
+                    __builtin_prefetch((first + g)->operator->());
+            }
+        }
+#else
+        (void)first;
+        (void)secondChild;
+        (void)len;
+#endif
+    }
+};
+
+/*
+ * bulk pop heap policy
+ *
+ * sets the thresholds of the bulk removal of pop_until(): after PopMin
+ * individual pops on heaps of at least HeapMin elements, the rest of the
+ * elements to pop are removed in one pass. ie: Base::bulk_pop_policy<0, 0>
+ * removes every burst in one pass. The best values depend on the memory
+ * system and on the burst sizes: measure them with the expiry workload
+ * of heap_indirect_bench. (see HeapHelpers::BulkPopMin)
+ *
+ * Policy is the policy extended with the thresholds.
+ */
+template <std::size_t PopMin, std::size_t HeapMin,
+          typename Policy = default_policy>
+struct bulk_pop_policy : Policy
+{
+    static constexpr std::size_t bulk_pop_min      = PopMin;
+    static constexpr std::size_t bulk_pop_heap_min = HeapMin;
+
+    constexpr bulk_pop_policy() = default;
+    explicit constexpr bulk_pop_policy(const Policy &policy) : Policy(policy) {}
+};
+
+/*
+ * key-id pair heap element
+ *
+ * the keyed_ptr of integer ids. The key is cached inline next to the id
+ * so that comparisons do not read a side array of keys. Use key_compare
+ * to compare them and handle_table_policy to record the positions.
+ * (see Base::VertexPriorityQueue)
+ */
+template <typename Key, typename Id = std::uint32_t>
+struct keyed_id
+{
+    using key_type = Key;
+    using id_type  = Id;
+
+    Key key;
+    Id  id;
+};
+
+/*
+ * key-pointer pair heap element
+ *
+ * caches the element key inline next to the element pointer so that
+ * comparisons read the contiguous heap array instead of dereferencing
+ * every element. Positions are still recorded in the pointed element by
+ * forwarding setHeapIndex() and getHeapIndex() to it.
+ *
+ * Use key_compare to compare the cached keys and update_key() to change
+ * the key of an element in the heap.
+ */
+template <typename Key, typename T>
+struct keyed_ptr
+{
+    using key_type     = Key;
+    using element_type = T;
+
+    Key key;
+    T  *ptr;
+};
+
+template <typename Key, typename T, typename Distance>
+constexpr inline void
+setHeapIndex(keyed_ptr<Key, T> &e, Distance idx)
+{
+    setHeapIndex(e.ptr, idx);
+}
+
+template <typename Key, typename T>
+constexpr inline auto
+getHeapIndex(const keyed_ptr<Key, T> &e)
+{
+    return getHeapIndex(e.ptr);
+}
+
+/*
+ * intrusive heap hook
+ *
+ * stores the position of an object in a heap. Deriving from it provides
+ * the setHeapIndex() and getHeapIndex() functions required by the
+ * algorithms for pointers to the object:
+ *
+ * struct Timer : Base::heap_hook<uint32_t> { ... };
+ * std::vector<Timer *> heap;
+ *
+ * IndexT sets the index width so that the hook does not grow hot objects
+ * more than needed. npos, the largest IndexT value, is reserved for
+ * objects that are not in a heap: it is the initial value and the owner
+ * stores it back with clearHeapIndex() once the object has been removed.
+ * The positions go up to npos - 1, the heaps hold at most max_heap_size
+ * (npos) objects, ie: 65535 with uint16_t. Storing a position that does
+ * not fit is caught by an assertion.
+ *
+ * An object that is in several heaps at once derives from one hook per
+ * heap, each with its own Tag, and the heaps hold Base::hook_ptr<T, Tag>
+ * to select their hook.
+ *
+ * The hook is not atomic so it cannot be used with the concurrent
+ * queues.
+ */
+struct default_hook_tag {};
+
+template <typename IndexT = std::size_t, typename Tag = default_hook_tag>
+class heap_hook
+{
+public:
+    static_assert(std::is_unsigned_v<IndexT>, "heap index must be unsigned");
+
+    using index_type = IndexT;
+    using tag_type   = Tag;
+
+    static constexpr IndexT npos = std::numeric_limits<IndexT>::max();
+    static constexpr std::size_t max_heap_size = npos;
+
+    constexpr IndexT heapIndex() const noexcept { return m_heapIndex; }
+    constexpr bool inHeap() const noexcept { return m_heapIndex != npos; }
+
+    template <typename Distance>
+    friend constexpr void setHeapIndex(heap_hook *h, Distance idx) noexcept
+    {
+        assert(static_cast<std::make_unsigned_t<Distance> >(idx) < npos);
+        h->m_heapIndex = static_cast<IndexT>(idx);
+    }
+
+    // mark the object as not in a heap
+    friend constexpr void clearHeapIndex(heap_hook *h) noexcept
+    {
+        h->m_heapIndex = npos;
+    }
+
+    friend constexpr IndexT getHeapIndex(const heap_hook *h) noexcept
+    {
+        return h->m_heapIndex;
+    }
+
+private:
+    IndexT m_heapIndex{npos};
+};
+
+namespace HeapHelpers {
+/*
+ * the Tag hook of an object, whatever its index type
+ */
+template <typename Tag, typename IndexT>
+constexpr inline heap_hook<IndexT, Tag> *
+hookOf(heap_hook<IndexT, Tag> *h) noexcept
+{
+    return h;
+}
+}
+
+/*
+ * pointer heap element selecting the Tag hook of objects that derive from
+ * more than one heap_hook.
+ *
+ * converts to T * so that comparison functors taking T * can be used
+ * unchanged.
+ */
+template <typename T, typename Tag>
+class hook_ptr
+{
+public:
+    using element_type = T;
+
+    constexpr hook_ptr(T *p = nullptr) noexcept : m_p(p) {}
+
+    constexpr T *get() const noexcept { return m_p; }
+    constexpr operator T *() const noexcept { return m_p; }
+    constexpr T *operator->() const noexcept { return m_p; }
+    constexpr T &operator*() const noexcept { return *m_p; }
+
+    template <typename Distance>
+    friend constexpr void setHeapIndex(hook_ptr h, Distance idx) noexcept
+    {
+        setHeapIndex(HeapHelpers::hookOf<Tag>(h.m_p), idx);
+    }
+
+    friend constexpr auto getHeapIndex(hook_ptr h) noexcept
+    {
+        return getHeapIndex(HeapHelpers::hookOf<Tag>(h.m_p));
+    }
+
+private:
+    T *m_p;
+};
+
+/*
+ * apply Compare on the elements key member
+ */
+template <typename Compare = std::less<> >
+struct key_compare
+{
+    [[no_unique_address]] Compare comp{};
+
+    template <typename Lhs, typename Rhs>
+    constexpr bool operator()(const Lhs &lhs, const Rhs &rhs) const
+    {
+        return comp(lhs.key, rhs.key);
+    }
+};
+
+/*
+ * FIFO order among equal priorities
+ *
+ * heaps are not stable: Compare alone pops the elements of equal priority
+ * in no particular order. fifo_compare breaks the ties with an insertion
+ * sequence number, read by ADL, the oldest element first:
+ *
+ * std::uint64_t getHeapSequence(const value_type &);
+ *
+ * Base::IndirectPriorityQueue stamps the pushed elements providing
+ *
+ * void setHeapSequence(value_type &, std::uint64_t);
+ *
+ * ie: orders at the same price served in arrival order. Either sift can be
+ * used.
+ */
+template <typename Compare = std::less<> >
+struct fifo_compare
+{
+    [[no_unique_address]] Compare comp{};
+
+    template <typename Lhs, typename Rhs>
+    constexpr bool operator()(const Lhs &lhs, const Rhs &rhs) const
+    {
+        if (comp(lhs, rhs))
+            return true;
+        if (comp(rhs, lhs))
+            return false;
+        return getHeapSequence(rhs) < getHeapSequence(lhs);
+    }
+};
+
+/*
+ * apply Compare on the keys of integer ids stored in a side array
+ */
+template <typename Key, typename Compare = std::less<Key> >
+struct id_compare
+{
+    const Key *keys;
+    [[no_unique_address]] Compare comp{};
+
+    template <typename Id>
+    constexpr bool operator()(Id lhs, Id rhs) const
+    {
+        return comp(keys[lhs], keys[rhs]);
+    }
+};
+
+/*
+ * the root of the heap is the highest priority element
+ * when an element is popped, it is the first element is moved in the last
+ * element and the last element is placed in its right place by calling
+ * downheap.
+ */
+namespace HeapHelpers {
+/*
+ * comparison functor wrapper used by instrumented policies
+ */
+template<typename Compare, typename Policy>
+struct counted_compare
+{
+    Compare &comp;
+    Policy  &policy;
+
+    template <typename Lhs, typename Rhs>
+    constexpr bool operator()(const Lhs &lhs, const Rhs &rhs) const
+    {
+        policy.onCompare();
+        return comp(lhs, rhs);
+    }
+};
+
+/*
+ * returns the comparison functor to use with policy.
+ */
+template<typename Compare, typename Policy>
+constexpr inline decltype(auto)
+instrument(Compare & comp, Policy & policy)
+{
+    if constexpr (Policy::instrumented)
+        return counted_compare<Compare, Policy>{comp, policy};
+    else
+        return (comp);
+}
+
+/*
+ * record that e is now in the slot k. A policy providing
+ *
+ * void recordHeapIndex(value_type &, Distance);
+ *
+ * records it instead of setHeapIndex(). (see Base::handle_table_policy)
+ */
+template<typename T, typename Distance, typename Policy>
+constexpr inline void
+recordHeapIndex(T & e, Distance k, Policy & policy)
+{
+    if constexpr (requires { policy.recordHeapIndex(e, k); })
+        policy.recordHeapIndex(e, k);
+    else
+        setHeapIndex(e, k);
+    policy.onSetHeapIndex();
+}
+
+/*
+ * position recorded for e. A policy recording the positions itself
+ * provides
+ *
+ * Distance heapIndex(const value_type &);
+ *
+ * to read them back instead of getHeapIndex().
+ */
+template<typename T, typename Policy>
+constexpr inline auto
+storedHeapIndex(const T & e, Policy & policy)
+{
+    if constexpr (requires { policy.heapIndex(e); })
+        return policy.heapIndex(e);
+    else
+        return getHeapIndex(e);
+}
+
+/*
+ * end of a mutation leaving the heap [first,last). A policy providing
+ *
+ * void verify(first, last, isHeapUntil);
+ *
+ * checks it first with isHeapUntil(first, last), the is_heap_until() of
+ * the heap layout. (see Base::verify_policy)
+ */
+template<typename RandomAccessIterator, typename IsHeapUntil, typename Policy>
+constexpr inline void
+endOpWith(RandomAccessIterator first, RandomAccessIterator last,
+          IsHeapUntil isHeapUntil, Policy & policy)
+{
+    if constexpr (requires { policy.verify(first, last, isHeapUntil); })
+        policy.verify(first, last, isHeapUntil);
+    policy.endOp();
+}
+
+/*
+ * first element of [first,last) whose recorded position is not its slot,
+ * last if there is none. Checks the heaps built without comparison.
+ */
+template<typename RandomAccessIterator, typename Policy>
+constexpr RandomAccessIterator
+recorded_until(RandomAccessIterator first, RandomAccessIterator last,
+               Policy & policy)
+{
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    for (DistanceType k{}; first + k != last; ++k) {
+        if (static_cast<DistanceType>(storedHeapIndex(*(first + k), policy)) != k)
+            return first + k;
+    }
+    return last;
+}
+
+/*
+ * end of a mutation leaving the heap [first,last), whose order comes
+ * from the caller. Only the recorded positions are checked.
+ */
+template<typename RandomAccessIterator, typename Policy>
+constexpr inline void
+endOrderedOp(RandomAccessIterator first, RandomAccessIterator last,
+             Policy & policy)
+{
+    endOpWith(first, last,
+              [&policy](auto f, auto l) {
+                  return recorded_until(f, l, policy);
+              },
+              policy);
+}
+
+/*
+ * store v in the slot k and record its new position
+ */
+template<typename RandomAccessIterator, typename Distance,
+         typename itemType, typename Policy>
+constexpr inline void
+place(RandomAccessIterator first, Distance k, itemType &&v, Policy & policy)
+{
+    auto it{first + k};
+
+    *(it) = std::forward<itemType>(v);
+    policy.onMove();
+    recordHeapIndex(*it, k, policy);
+}
+
+/*
+ * let the policy prefetch while the children secondChild - 1 and
+ * secondChild are compared. (see Base::prefetch_policy)
+ */
+template<typename RandomAccessIterator, typename Distance, typename Policy>
+constexpr inline void
+prefetchBelow(RandomAccessIterator first, Distance secondChild, Distance len,
+              Policy & policy)
+{
+    if constexpr (requires { policy.prefetch(first, secondChild, len); })
+        policy.prefetch(first, secondChild, len);
+}
+
+template<typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr Distance
+upheap(RandomAccessIterator first,
+       Distance k,
+       Distance topIndex,
+       itemType v, Compare & comp, Policy & policy)
+{
+    Distance parent{(k - 1) / 2};
+
+    while (k > topIndex && // sentinel
+           comp(*(first + parent), v)) { // if v is greater (if comp is less)
+        policy.onLevel();
+        // move down the parent
+        place(first, k, std::move(*(first + parent)), policy);
+        k = parent;
+        parent = (k - 1) / 2;
+    }
+    place(first, k, std::move(v), policy);
+    return k;
+}
+
+/*
+ * top-down sift: at each level, pick the best child and stop as soon as v is
+ * not smaller than it. 2 comparisons per level visited.
+ */
+template<typename RandomAccessIterator, typename Distance,
+         typename itemType, typename Compare, typename Policy>
+constexpr void
+downheap(RandomAccessIterator first,
+         const Distance /* topIndex */, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy, top_down_sift)
+{
+    /*
+     * initialize secondChild with k to start inspecting its children in the
+     * following loop
+     */
+    Distance secondChild = k;
+
+    // move up the best child
+    while (secondChild < (len - 1) / 2) {
+        secondChild = 2 * (secondChild + 1);
+        prefetchBelow(first, secondChild, len, policy);
+        // pick the biggest child
+        if (comp(*(first + secondChild),
+                 *(first + (secondChild - 1))))
+            --secondChild;
+        if (!comp(v, *(first + secondChild)))
+            break;
+        policy.onLevel();
+        place(first, k, std::move(*(first + secondChild)), policy);
+        k = secondChild;
+    }
+    /*
+     * if heap size is even, the last parent has a single child that is
+     * not inspected by the loop above.
+     *
+     * NOTE:
+     * if the loop has been exited by the break, k has 2 children so
+     * it cannot be the last parent.
+     */
+    if ((len & 1) == 0 &&
+        k == (len - 2) / 2) {
+        const Distance lastChild{len - 1};
+
+        if (comp(v, *(first + lastChild))) {
+            policy.onLevel();
+            place(first, k, std::move(*(first + lastChild)), policy);
+            k = lastChild;
+        }
+    }
+    place(first, k, std::move(v), policy);
+}
+
+/*
+ * bottom-up sift: move the hole down to a leaf along the path of the best
+ * children without comparing them with v and then upheap v from the leaf.
+ * 1 comparison per level on the way down and since v usually comes from the
+ * bottom of the heap, very few on the way up.
+ */
+template<typename RandomAccessIterator, typename Distance,
+         typename itemType, typename Compare, typename Policy>
+constexpr void
+downheap(RandomAccessIterator first,
+         const Distance topIndex, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy, bottom_up_sift)
+{
+    /*
+     * initialize secondChild with k to start inspecting its children in the
+     * following loop
+     */
+    Distance secondChild = k;
+
+    // move up the best child
+    while (secondChild < (len - 1) / 2) {
+        secondChild = 2 * (secondChild + 1);
+        prefetchBelow(first, secondChild, len, policy);
+        // pick the biggest child
+        if (comp(*(first + secondChild),
+                 *(first + (secondChild - 1))))
+            --secondChild;
+        policy.onLevel();
+        place(first, k, std::move(*(first + secondChild)), policy);
+        k = secondChild;
+    }
+    /*
+     * if heap size is odd
+     * and secondchild points on the leaves on the previous generation:
+     * ie: len=15, secondChild=6,
+     *
+     * place the last heap element in the previous generation unique leaf
+     * so that the upheap starts on the latest generation.
+     */
+    if ((len & 1) == 0 &&
+        secondChild == (len - 2) / 2) {
+        secondChild = 2 * (secondChild + 1);
+        const auto secondChildIdx{secondChild - 1};
+
+        policy.onLevel();
+        place(first, k, std::move(*(first + secondChildIdx)), policy);
+        k = secondChildIdx;
+    }
+
+    /*
+     * at this point, k points to the hole, upheap the heap
+     * with v from this point.
+     */
+    upheap(first, k, topIndex, std::move(v), comp, policy);
+}
+
+template<typename RandomAccessIterator, typename Distance,
+         typename itemType, typename Compare, HeapPolicy Policy>
+constexpr inline void
+downheap(RandomAccessIterator first,
+         const Distance topIndex, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy)
+{
+    downheap(first, topIndex, k, len, std::move(v), comp, policy,
+             typename Policy::sift_strategy{});
+}
+
+/*
+ * place v in the hole at k by moving it up or down, whichever direction
+ * fixes the heap condition. Only one of the 2 sifts does any work.
+ */
+template<typename RandomAccessIterator, typename Distance,
+         typename itemType, typename Compare, typename Policy>
+constexpr inline void
+adjust(RandomAccessIterator first, Distance k, Distance len,
+       itemType v, Compare & comp, Policy & policy)
+{
+    if (k > 0 && comp(*(first + (k - 1) / 2), v))
+        upheap(first, k, Distance{}, std::move(v), comp, policy);
+    else
+        downheap(first, k, // v cannot go above k
+                 k, len, std::move(v), comp, policy);
+}
+
+template<typename RandomAccessIterator, typename Compare, typename Policy>
+constexpr inline void
+remove(RandomAccessIterator first, RandomAccessIterator last,
+       RandomAccessIterator popPos, RandomAccessIterator result,
+       Compare& comp, Policy & policy)
+{
+    using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    // popping the last element leaves the rest of the heap untouched
+    if (popPos == result)
+        return;
+
+    /*
+     * previous smallest priority element is stored in v
+     * to be repositioned.
+     */
+    ValueType v{std::move(*result)};
+
+    // popPos is going to be popped
+    *result = std::move(*popPos);
+    policy.onMove();
+
+    /*
+     * when popPos is not the root, v may as well have a higher priority than
+     * popPos parent.
+     */
+    adjust(first,
+           DistanceType{popPos - first}, // k
+           DistanceType(last - first),   // len
+           std::move(v), comp, policy);
+}
+}
+
+/**
+ *  @brief  Find the end of the valid part of an indirect heap.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return The first element that breaks the heap condition or whose
+ *          recorded position is not its slot, last if there is none.
+ *  @ingroup heap_algorithms
+ *
+ *  Unlike std::is_heap_until(), a stale position, which would corrupt the
+ *  heap at the next erase() or update() of its element, is also detected.
+ *  The positions are read by getHeapIndex() or by the policy. (see
+ *  HeapHelpers::storedHeapIndex())
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr RandomAccessIterator
+is_heap_until(RandomAccessIterator first, RandomAccessIterator last,
+              Compare comp, Policy policy = {})
+{
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    const DistanceType len{last - first};
+
+    for (DistanceType k{}; k < len; ++k) {
+        const auto &e{*(first + k)};
+
+        if (static_cast<DistanceType>(HeapHelpers::storedHeapIndex(e, policy)) != k ||
+            (k > 0 && comp(*(first + (k - 1) / 2), e)))
+            return first + k;
+    }
+    return last;
+}
+
+/*
+ * true if [first,last) is a heap whose elements positions are all
+ * recorded. (see Base::is_heap_until())
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr bool
+verify_heap(RandomAccessIterator first, RandomAccessIterator last,
+            Compare comp, Policy policy = {})
+{
+    return Base::is_heap_until(first, last, std::move(comp),
+                               std::move(policy)) == last;
+}
+
+namespace HeapHelpers {
+/*
+ * end of a mutation leaving the binary heap [first,last)
+ */
+template<typename RandomAccessIterator, typename Compare, typename Policy>
+constexpr inline void
+endOp(RandomAccessIterator first, RandomAccessIterator last, Compare & comp,
+      Policy & policy)
+{
+    endOpWith(first, last,
+              [&comp, &policy](auto f, auto l) {
+                  return Base::is_heap_until(f, l, comp, policy);
+              },
+              policy);
+}
+
+struct abort_on_corrupt
+{
+    [[noreturn]] void operator()(std::size_t pos) const noexcept
+    {
+        std::fprintf(stderr, "indirect heap corrupted at position %zu\n", pos);
+        std::abort();
+    }
+};
+}
+
+/*
+ * debug heap policy
+ *
+ * checks the heap with Base::is_heap_until() at the end of every
+ * mutation, in O(n), and calls onCorrupt(position) with the first element
+ * in error. By default, the position is printed and the process aborted.
+ *
+ * For test builds and fuzzing only. The d-ary, B-heap and min-max
+ * algorithms check their own layout. (see dary::is_heap_until(),
+ * bheap::is_heap_until() and minmax::is_heap_until()) make_heap_sorted()
+ * and restore_heap() take the order from the caller, without comparison,
+ * so only the recorded positions are checked there.
+ *
+ * Policy is the policy extended with the checks.
+ */
+template <typename Policy = default_policy,
+          typename OnCorrupt = HeapHelpers::abort_on_corrupt>
+struct verify_policy : Policy
+{
+    [[no_unique_address]] OnCorrupt onCorrupt;
+
+    constexpr verify_policy() = default;
+    explicit constexpr verify_policy(const Policy &policy,
+                                     const OnCorrupt &handler = OnCorrupt())
+    : Policy(policy), onCorrupt(handler) {}
+
+    template <typename RandomAccessIterator, typename IsHeapUntil>
+    constexpr void verify(RandomAccessIterator first, RandomAccessIterator last,
+                          IsHeapUntil &isHeapUntil)
+    {
+        const auto bad{isHeapUntil(first, last)};
+
+        if (bad != last)
+            onCorrupt(static_cast<std::size_t>(bad - first));
+    }
+};
+
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+upheap(RandomAccessIterator first, RandomAccessIterator last,
+       RandomAccessIterator changed, Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    ValueType v = std::move(*changed);
+
+    HeapHelpers::upheap(first,                         // first
+                        DistanceType(changed - first), // k
+                        DistanceType{},                // top index
+                        std::move(v), c, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+downheap(RandomAccessIterator first, RandomAccessIterator last,
+         RandomAccessIterator changed, Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    ValueType v = std::move(*changed);
+
+    HeapHelpers::downheap(first, DistanceType{},         // topIndex
+                          DistanceType{changed - first}, // k
+                          DistanceType(last - first),    // len
+                          std::move(v), c, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+namespace HeapHelpers {
+template<typename RandomAccessIterator, typename Compare, typename Policy>
+constexpr inline void
+update(RandomAccessIterator first, RandomAccessIterator last,
+       RandomAccessIterator changed, Compare & comp, Policy & policy)
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    ValueType v = std::move(*changed);
+
+    adjust(first,
+           DistanceType{changed - first}, // k
+           DistanceType(last - first),    // len
+           std::move(v), comp, policy);
+}
+}
+
+/*
+ * restore the heap condition after the priority of the changed element has
+ * been modified in either direction.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+update_heap(RandomAccessIterator first, RandomAccessIterator last,
+            RandomAccessIterator changed, Compare comp, Policy policy = {})
+{
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    HeapHelpers::update(first, last, changed, c, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Change the key of an element and restore the heap condition.
+ *  @param  first    Start of heap.
+ *  @param  last     End of heap.
+ *  @param  changed  Element to update.
+ *  @param  key      New key.
+ *  @param  comp     Comparison functor.
+ *  @param  policy   Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  For heap elements caching their key like Base::keyed_ptr. Only the
+ *  cached key is written, updating the pointed element is up to the caller.
+ */
+template<typename RandomAccessIterator, typename Key, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+update_key(RandomAccessIterator first, RandomAccessIterator last,
+           RandomAccessIterator changed, Key &&key, Compare comp,
+           Policy policy = {})
+{
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    (*changed).key = std::forward<Key>(key);
+    HeapHelpers::update(first, last, changed, c, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Push an element onto a heap using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap + element.
+ *  @param  comp   Comparison functor.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  This operation pushes the element at last-1 onto the valid
+ *  heap over the range [first,last-1).  After completion,
+ *  [first,last) is a valid heap.  Compare operations are
+ *  performed using comp.
+*/
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+push_heap(RandomAccessIterator first, RandomAccessIterator last,
+          Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::push);
+    ValueType v = std::move(*(last - 1));
+
+    HeapHelpers::upheap(first, DistanceType((last - 1) - first), // k
+                        DistanceType{},                          // top index
+                        std::move(v), c, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Pop an element off a heap using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  This operation pops the top of the heap.  The elements first
+ *  and last-1 are swapped and [first,last-1) is made into a
+ *  heap.  Comparisons are made using comp.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+pop_heap(RandomAccessIterator first,
+         RandomAccessIterator last, Compare comp, Policy policy = {})
+{
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::pop);
+    if (last - first > 1) {
+        --last;
+        HeapHelpers::remove(first, last, first, last, c, policy);
+    }
+    else {
+        last = first;
+    }
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+pop_heap(RandomAccessIterator first, RandomAccessIterator last,
+         RandomAccessIterator popPos,
+         Compare comp, Policy policy = {})
+{
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::erase);
+    if (last - first > 1) {
+        --last;
+        HeapHelpers::remove(first, last, popPos, last, c, policy);
+    }
+    else {
+        last = first;
+    }
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Replace the top of a heap by a new element.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  v      New element.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return The former top.
+ *  @ingroup heap_algorithms
+ *
+ *  Same result as pop_heap() followed by push_heap() of v but with a
+ *  single downheap from the root. [first,last) must not be empty. The
+ *  position of the former top is not changed.
+ *
+ *  To re-arm the top element itself (ie: a periodic timer), change its
+ *  priority in place and call downheap(first, last, first, comp).
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline typename std::iterator_traits<RandomAccessIterator>::value_type
+replace_top(RandomAccessIterator first, RandomAccessIterator last,
+            typename std::iterator_traits<RandomAccessIterator>::value_type v,
+            Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::replace);
+    ValueType top{std::move(*first)};
+
+    HeapHelpers::downheap(first, DistanceType{},      // topIndex
+                          DistanceType{},             // k
+                          DistanceType(last - first), // len
+                          std::move(v), c, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+    return top;
+}
+
+/*
+ * replace the element at pos by v and return it. v is sifted in whichever
+ * direction it belongs.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline typename std::iterator_traits<RandomAccessIterator>::value_type
+replace_at(RandomAccessIterator first, RandomAccessIterator last,
+           RandomAccessIterator pos,
+           typename std::iterator_traits<RandomAccessIterator>::value_type v,
+           Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::replace);
+    ValueType old{std::move(*pos)};
+
+    HeapHelpers::adjust(first,
+                        DistanceType{pos - first},  // k
+                        DistanceType(last - first), // len
+                        std::move(v), c, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+    return old;
+}
+
+/*
+ * replace the top by v in a single sift unless v would be the new top,
+ * and move the former top to v. Returns false, without touching the heap
+ * nor v, when v would be the new top. The comparison with the top is
+ * part of the operation reported to the policy.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline bool
+try_replace_top(RandomAccessIterator first, RandomAccessIterator last,
+                typename std::iterator_traits<RandomAccessIterator>::value_type &v,
+                Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::replace);
+    if (first == last || !c(v, *first)) {
+        HeapHelpers::endOp(first, last, comp, policy);
+        return false;
+    }
+
+    ValueType top{std::move(*first)};
+
+    HeapHelpers::downheap(first, DistanceType{},      // topIndex
+                          DistanceType{},             // k
+                          DistanceType(last - first), // len
+                          std::move(v), c, policy);
+    v = std::move(top);
+    HeapHelpers::endOp(first, last, comp, policy);
+    return true;
+}
+
+/*
+ * push v and pop the top in a single sift. v itself is returned, without
+ * touching the heap nor recording a position, when it would be the new
+ * top.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline typename std::iterator_traits<RandomAccessIterator>::value_type
+push_pop_heap(RandomAccessIterator first, RandomAccessIterator last,
+              typename std::iterator_traits<RandomAccessIterator>::value_type v,
+              Compare comp, Policy policy = {})
+{
+    Base::try_replace_top(first, last, v, std::move(comp), std::move(policy));
+    return v;
+}
+
+namespace HeapHelpers {
+/*
+ * record the position of every element of [first,last) with a single
+ * setHeapIndex() call each.
+ */
+template<typename RandomAccessIterator, typename Policy>
+constexpr inline void
+setHeapIndexes(RandomAccessIterator first, RandomAccessIterator last,
+               Policy & policy)
+{
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    for (DistanceType k{}; first != last; ++first, ++k)
+        recordHeapIndex(*first, k, policy);
+}
+}
+
+/**
+ *  @brief  Construct a heap over a range using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  This operation makes the elements in [first,last) into a heap in O(n)
+ *  using Floyd bottom-up construction. Elements positions are only
+ *  recorded once the heap is built so setHeapIndex() is called exactly once
+ *  per element instead of once per move.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+make_heap(RandomAccessIterator first, RandomAccessIterator last,
+          Compare comp, Policy policy = {})
+{
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::make);
+    std::make_heap(first, last, c);
+    HeapHelpers::setHeapIndexes(first, last, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Construct a heap over a range sorted by decreasing priority.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  A range sorted from the highest to the lowest priority already
+ *  satisfies the heap condition, whatever the heap arity is, so this only
+ *  records the elements positions. ie: with comp, sort [first,last) with
+ *  [&comp](const auto &a, const auto &b){ return comp(b, a); }
+ */
+template<typename RandomAccessIterator, HeapPolicy Policy = default_policy>
+constexpr inline void
+make_heap_sorted(RandomAccessIterator first, RandomAccessIterator last,
+                 Policy policy = {})
+{
+    policy.beginOp(heap_op::make);
+    HeapHelpers::setHeapIndexes(first, last, policy);
+    HeapHelpers::endOrderedOp(first, last, policy);
+}
+
+/**
+ *  @brief  Reinstate a heap whose elements are already in heap order.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  The elements of [first,last) are in the order of a heap, ie: restored
+ *  from a snapshot of its array (see heap_indirect_snapshot.h). Their
+ *  positions are recorded with a single setHeapIndex() call each, without
+ *  any comparison.
+ */
+template<typename RandomAccessIterator, HeapPolicy Policy = default_policy>
+constexpr inline void
+restore_heap(RandomAccessIterator first, RandomAccessIterator last,
+             Policy policy = {})
+{
+    policy.beginOp(heap_op::make);
+    HeapHelpers::setHeapIndexes(first, last, policy);
+    HeapHelpers::endOrderedOp(first, last, policy);
+}
+
+/**
+ *  @brief  Reinstate a heap after checking its order.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return  false if [first,last) was not a heap.
+ *  @ingroup heap_algorithms
+ *
+ *  restore_heap() preceded by a validation pass of n - 1 comparisons, for
+ *  an order read from an untrusted source. A range that is not a binary
+ *  heap for comp (ie: the priorities changed since the snapshot) is
+ *  rebuilt by make_heap() instead. The policy sees a single heap_op::make
+ *  operation including the validation.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline bool
+restore_heap_checked(RandomAccessIterator first, RandomAccessIterator last,
+                     Compare comp, Policy policy = {})
+{
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    // the validation is counted with the rebuild
+    policy.beginOp(heap_op::make);
+
+    const bool valid{std::is_heap(first, last, c)};
+
+    if (!valid)
+        std::make_heap(first, last, c);
+    HeapHelpers::setHeapIndexes(first, last, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+    return valid;
+}
+
+namespace HeapHelpers {
+/*
+ * restore the heap condition over [0,len) when [0,oldLen) is a heap and
+ * [oldLen,len) holds new elements.
+ *
+ * Floyd construction restricted to the ancestors of the new elements. At
+ * each level, these ancestors form a contiguous range of indices that is
+ * processed from right to left. Parts of the next range already sifted
+ * at the current level are skipped.
+ */
+template<typename RandomAccessIterator, typename Distance,
+         typename Compare, typename Policy>
+constexpr void
+reheapRange(RandomAccessIterator first, Distance oldLen, Distance len,
+            Compare & comp, Policy & policy)
+{
+    using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
+
+    // new elements that stay in place still need their position recorded
+    for (Distance k{oldLen}; k < len; ++k)
+        recordHeapIndex(*(first + k), k, policy);
+
+    Distance lo{(oldLen - 1) / 2};
+    Distance hi{(len - 2) / 2};
+
+    for (;;) {
+        for (Distance k{hi}; k >= lo; --k) {
+            ValueType v = std::move(*(first + k));
+
+            downheap(first, k, // topIndex
+                     k, len, std::move(v), comp, policy);
+        }
+        if (lo == 0)
+            break;
+        hi = std::min((hi - 1) / 2, lo - 1);
+        lo = (lo - 1) / 2;
+    }
+}
+
+/*
+ * depth of the node at index k. (the root is at depth 0)
+ */
+template<typename Distance>
+constexpr inline Distance
+depth(Distance k)
+{
+    return static_cast<Distance>(std::bit_width(static_cast<std::size_t>(k + 1))) - 1;
+}
+}
+
+/**
+ *  @brief  Push a range of elements onto a heap using comparison functor.
+ *  @param  first    Start of heap.
+ *  @param  oldLast  End of heap.
+ *  @param  newLast  End of heap + new elements.
+ *  @param  comp     Comparison functor.
+ *  @param  policy   Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  This operation pushes the elements [oldLast,newLast) onto the valid
+ *  heap over the range [first,oldLast).  After completion,
+ *  [first,newLast) is a valid heap.
+ *
+ *  A push_heap() costs 1 comparison plus 1 per level climbed. It is very
+ *  cheap for elements that stay near the bottom, like far deadlines, but
+ *  costs log2(n) for elements that climb to the top. The bottom-up reheap
+ *  of the remaining elements ancestors costs about 4 comparisons per
+ *  element plus 2 per level for the ancestors chain up to the root.
+ *
+ *  Elements are therefore pushed one at a time until the batch is seen
+ *  climbing more than 3 levels per element on average. The rest of the
+ *  batch is then merged with the bottom-up reheap if it is large enough to
+ *  amortize the ancestors chain.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr void
+push_heap_range(RandomAccessIterator first, RandomAccessIterator oldLast,
+                RandomAccessIterator newLast, Compare comp,
+                Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    const DistanceType len{newLast - first};
+    const DistanceType chainLen{HeapHelpers::depth(len - 1)};
+    DistanceType k{oldLast - first};
+    DistanceType pushed{};
+    DistanceType climbed{};
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::push);
+    for (; k < len; ++k, ++pushed) {
+        if (len - k > chainLen &&
+            climbed > 3 * pushed + chainLen) {
+            HeapHelpers::reheapRange(first, k, len, c, policy);
+            break;
+        }
+        ValueType v = std::move(*(first + k));
+        const DistanceType pos{HeapHelpers::upheap(first, k, DistanceType{},
+                                                   std::move(v), c, policy)};
+
+        climbed += HeapHelpers::depth(k) - HeapHelpers::depth(pos);
+    }
+    HeapHelpers::endOp(first, newLast, comp, policy);
+}
+
+/**
+ *  @brief  Merge two adjacent heaps using comparison functor.
+ *  @param  first   Start of the first heap.
+ *  @param  middle  End of the first heap, start of the second.
+ *  @param  last    End of the second heap.
+ *  @param  comp    Comparison functor.
+ *  @param  policy  Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  [first,middle) and [middle,last) are valid heaps.  After completion,
+ *  [first,last) is a valid heap.
+ *
+ *  The elements of the second heap are pushed in their heap order, which
+ *  keeps most of them close to the bottom: about 2 comparisons per element
+ *  with random keys, whatever the sizes, and log2(n/m) if the second heap
+ *  holds the highest priorities. This is faster than the restricted Floyd
+ *  reheap at every size measured, even though the reheap does fewer moves.
+ *  push_heap_range() still switches to the reheap when the elements climb
+ *  far.
+ *
+ *  Merging m elements into n costs at least m position updates, so merge
+ *  the smaller heap into the larger one.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+merge_heaps(RandomAccessIterator first, RandomAccessIterator middle,
+            RandomAccessIterator last, Compare comp, Policy policy = {})
+{
+    Base::push_heap_range(first, middle, last, std::move(comp),
+                          std::move(policy));
+}
+
+namespace HeapHelpers {
+/*
+ * pop_until() switches from individual pops to bulkPop() after
+ * BulkPopMin pops on heaps of at least BulkPopHeapMin elements. Smaller
+ * heaps stay in the caches and popping them one at a time is faster.
+ *
+ * default thresholds, measured with the expiry workload of
+ * heap_indirect_bench. A policy overrides them. (see
+ * Base::bulk_pop_policy)
+ */
+inline constexpr std::size_t BulkPopMin     = 8192;
+inline constexpr std::size_t BulkPopHeapMin = std::size_t{1} << 19;
+
+template <typename Policy>
+constexpr std::size_t bulkPopMin() noexcept
+{
+    if constexpr (requires { Policy::bulk_pop_min; })
+        return Policy::bulk_pop_min;
+    else
+        return BulkPopMin;
+}
+
+template <typename Policy>
+constexpr std::size_t bulkPopHeapMin() noexcept
+{
+    if constexpr (requires { Policy::bulk_pop_heap_min; })
+        return Policy::bulk_pop_heap_min;
+    else
+        return BulkPopHeapMin;
+}
+
+/*
+ * remove the elements of [0,len) for which pred holds and move them to
+ * out in priority order. Returns the new heap length.
+ *
+ * pred holds on a subtree from the root, collected in O(k). Its slots
+ * that are kept are filled with the last elements of the heap and only
+ * them are sifted down, from the deepest one up, like Floyd construction
+ * does. The subtrees hanging below are untouched heaps so a filled slot
+ * at depth d sinks at most log2(len) - d levels, instead of the full
+ * depth for a pop.
+ */
+template<typename RandomAccessIterator, typename Distance, typename Predicate,
+         typename OutputIterator, typename Compare, typename Policy>
+constexpr Distance
+bulkPop(RandomAccessIterator first, Distance len, Predicate & pred,
+        OutputIterator & out, Compare & comp, Policy & policy)
+{
+    using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    std::vector<Distance> holes;
+    std::vector<Distance> stack{Distance{}};
+
+    while (!stack.empty()) {
+        const Distance k{stack.back()};
+
+        stack.pop_back();
+        if (k >= len || !pred(*(first + k)))
+            continue;
+        holes.push_back(k);
+        stack.push_back(2 * k + 1);
+        stack.push_back(2 * k + 2);
+    }
+
+    std::vector<ValueType> popped;
+
+    popped.reserve(holes.size());
+    for (const Distance k : holes)
+        popped.push_back(std::move(*(first + k)));
+    std::sort(popped.begin(), popped.end(),
+              [&](const ValueType &a, const ValueType &b){ return comp(b, a); });
+    for (auto &v : popped) {
+        *out = std::move(v);
+        ++out;
+    }
+
+    std::sort(holes.begin(), holes.end());
+
+    const Distance newLen{len - static_cast<Distance>(holes.size())};
+    const auto     kept{std::lower_bound(holes.begin(), holes.end(), newLen)};
+    auto           tailHole{holes.end()};
+    Distance       tail{len - 1};
+
+    // move the last elements that are not popped in the kept holes
+    for (auto it{holes.begin()}; it != kept; ++it, --tail) {
+        while (tailHole != kept && *(tailHole - 1) == tail) {
+            --tailHole;
+            --tail;
+        }
+        *(first + *it) = std::move(*(first + tail));
+        policy.onMove();
+    }
+    for (auto it{kept}; it != holes.begin();) {
+        const Distance k{*--it};
+        ValueType v = std::move(*(first + k));
+
+        downheap(first, k, // v cannot go above k
+                 k, newLen, std::move(v), comp, policy);
+    }
+    return newLen;
+}
+}
+
+/**
+ *  @brief  Pop the top elements of a heap while a predicate holds.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  pred   Predicate of the elements to pop.
+ *  @param  out    Destination of the popped elements.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return End of the remaining heap.
+ *  @ingroup heap_algorithms
+ *
+ *  Moves the elements for which pred holds to out in priority order and
+ *  leaves the remaining ones in the heap [first,result). The content of
+ *  [result,last) is unspecified. pred must hold for every element of
+ *  higher priority than an element for which it holds. (ie: deadline <=
+ *  now with a min-heap of deadlines)
+ *
+ *  Elements are popped one at a time. On large heaps, once more than
+ *  HeapHelpers::BulkPopMin elements have been popped, the rest are
+ *  removed in one pass. (see HeapHelpers::bulkPop() and
+ *  Base::bulk_pop_policy)
+ */
+template<typename RandomAccessIterator, typename Predicate,
+         typename OutputIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr RandomAccessIterator
+pop_until(RandomAccessIterator first, RandomAccessIterator last,
+          Predicate pred, OutputIterator out, Compare comp,
+          Policy policy = {})
+{
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+    DistanceType len{last - first};
+    const bool bulk{static_cast<std::size_t>(len) >=
+                    HeapHelpers::bulkPopHeapMin<Policy>()};
+    std::size_t popped{};
+
+    policy.beginOp(heap_op::pop);
+    for (; len > 0 && pred(*first); ++popped) {
+        if (bulk && popped == HeapHelpers::bulkPopMin<Policy>()) {
+            len = HeapHelpers::bulkPop(first, len, pred, out, c, policy);
+            break;
+        }
+        --len;
+        HeapHelpers::remove(first, first + len, first, first + len, c, policy);
+        *out = std::move(*(first + len));
+        ++out;
+    }
+    HeapHelpers::endOp(first, first + len, comp, policy);
+    return first + len;
+}
+
+/**
+ *  @brief  Pop the n top elements of a heap.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  n      Number of elements to pop.
+ *  @param  out    Destination of the popped elements.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return End of the remaining heap.
+ *  @ingroup heap_algorithms
+ *
+ *  Moves the min(n, last - first) highest priority elements to out in
+ *  priority order. The content of [result,last) is unspecified.
+ *
+ *  Unlike pop_until(), the popped elements are not known before they are
+ *  popped. Selecting them best first costs more than the pops themselves,
+ *  so they are popped one at a time.
+ */
+template<typename RandomAccessIterator, typename OutputIterator,
+         typename Compare, HeapPolicy Policy = default_policy>
+constexpr RandomAccessIterator
+pop_n(RandomAccessIterator first, RandomAccessIterator last,
+      typename std::iterator_traits<RandomAccessIterator>::difference_type n,
+      OutputIterator out, Compare comp, Policy policy = {})
+{
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{HeapHelpers::instrument(comp, policy)};
+    DistanceType len{last - first};
+    const DistanceType newLen{len - std::min(n, len)};
+
+    policy.beginOp(heap_op::pop);
+    while (len > newLen) {
+        --len;
+        HeapHelpers::remove(first, first + len, first, first + len, c, policy);
+        *out = std::move(*(first + len));
+        ++out;
+    }
+    HeapHelpers::endOp(first, first + len, comp, policy);
+    return first + len;
+}
+
+/*
+ * d-ary variant of the indirect heap algorithms
+ *
+ * same interface as the binary algorithms above except that the node
+ * fan-out is given by the Arity template parameter:
+ *
+ * Base::dary::push_heap<4>(first, last, comp);
+ *
+ * A wider node reduces the heap depth to log_d(n) levels at the cost of
+ * d - 1 comparisons per level to pick the best child. Since the children
+ * of a node are contiguous, with pointer elements, 4 or 8 children fit in a
+ * single cache line so each level visited by downheap touches one line.
+ */
+namespace dary {
+namespace HeapHelpers {
+template<std::size_t Arity, typename Distance>
+constexpr inline Distance
+parent(Distance k)
+{
+    return (k - 1) / static_cast<Distance>(Arity);
+}
+
+template<std::size_t Arity, typename Distance>
+constexpr inline Distance
+firstChild(Distance k)
+{
+    return static_cast<Distance>(Arity) * k + 1;
+}
+
+using Base::HeapHelpers::place;
+
+template<std::size_t Arity,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr void
+upheap(RandomAccessIterator first,
+       Distance k,
+       Distance topIndex,
+       itemType v, Compare & comp, Policy & policy)
+{
+    Distance p{parent<Arity>(k)};
+
+    while (k > topIndex && // sentinel
+           comp(*(first + p), v)) { // if v is greater (if comp is less)
+        policy.onLevel();
+        // move down the parent
+        place(first, k, std::move(*(first + p)), policy);
+        k = p;
+        p = parent<Arity>(k);
+    }
+    place(first, k, std::move(v), policy);
+}
+
+/*
+ * vectorized child selection
+ *
+ * with 8 or 16 children, picking the best child is a min or max reduction
+ * over the children keys. When the heap elements are Base::keyed_ptr with
+ * a 64-bit integer or a double key compared by Base::key_compare over
+ * std::less or std::greater, it is done with AVX-512 or AVX2 instructions
+ * depending on the compilation target. (ie: -march=native)
+ *
+ * Like the scalar scan, the first of equal best children is selected.
+ * double keys must not be NaN.
+ */
+namespace simd {
+template<typename Compare, typename Key>
+struct keyOrder
+{
+    static constexpr bool supported = false;
+};
+
+template<typename Key>
+struct keyOrder<std::less<>, Key>
+{
+    static constexpr bool supported = true;
+    static constexpr bool max       = true;
+};
+
+template<typename Key>
+struct keyOrder<std::less<Key>, Key> : keyOrder<std::less<>, Key> {};
+
+template<typename Key>
+struct keyOrder<std::greater<>, Key>
+{
+    static constexpr bool supported = true;
+    static constexpr bool max       = false;
+};
+
+template<typename Key>
+struct keyOrder<std::greater<Key>, Key> : keyOrder<std::greater<>, Key> {};
+
+template<typename Key>
+inline constexpr bool isInt64Key = std::is_integral_v<Key> &&
+                                   std::is_signed_v<Key> &&
+                                   sizeof(Key) == 8;
+
+template<typename Key>
+inline constexpr bool isSimdKey = isInt64Key<Key> ||
+                                  std::is_same_v<Key, double>;
+
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare>
+struct selectable
+{
+    static constexpr bool value = false;
+};
+
+template<std::size_t Arity, typename RandomAccessIterator,
+         typename Key, typename T, typename Compare>
+struct selectableElem
+{
+    static constexpr bool value =
+#if defined(__AVX2__)
+        (Arity == 8 || Arity == 16) &&
+        std::contiguous_iterator<RandomAccessIterator> &&
+        isSimdKey<Key> &&
+        sizeof(keyed_ptr<Key, T>) == 2 * sizeof(Key) &&
+        keyOrder<Compare, Key>::supported;
+#else
+        false;
+#endif
+};
+
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare>
+    requires requires {
+        typename std::iter_value_t<RandomAccessIterator>::key_type;
+        typename std::iter_value_t<RandomAccessIterator>::element_type;
+    }
+struct selectable<Arity, RandomAccessIterator, key_compare<Compare> >
+{
+    using ValueType = std::iter_value_t<RandomAccessIterator>;
+    using Key       = typename ValueType::key_type;
+    using T         = typename ValueType::element_type;
+
+    static constexpr bool value =
+        std::is_same_v<ValueType, keyed_ptr<Key, T> > &&
+        selectableElem<Arity, RandomAccessIterator, Key, T, Compare>::value;
+};
+
+#if defined(__AVX512F__)
+/*
+ * gather the keys of 8 key-pointer pairs in a single register
+ */
+inline __m512i
+load8Keys(const char *p, __m512i)
+{
+    const __m512i idx{_mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14)};
+
+    return _mm512_permutex2var_epi64(_mm512_loadu_si512(p), idx,
+                                     _mm512_loadu_si512(p + 64));
+}
+
+inline __m512d
+load8Keys(const char *p, __m512d)
+{
+    const __m512i idx{_mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14)};
+
+    return _mm512_permutex2var_pd(_mm512_loadu_pd(p), idx,
+                                  _mm512_loadu_pd(p + 64));
+}
+
+template<bool Max>
+inline __m512i best(__m512i a, __m512i b)
+{
+    return Max ? _mm512_max_epi64(a, b) : _mm512_min_epi64(a, b);
+}
+
+template<bool Max>
+inline __m512d best(__m512d a, __m512d b)
+{
+    return Max ? _mm512_max_pd(a, b) : _mm512_min_pd(a, b);
+}
+
+template<bool Max>
+inline __m512i bestAllLanes(__m512i v)
+{
+    return _mm512_set1_epi64(Max ? _mm512_reduce_max_epi64(v) :
+                                   _mm512_reduce_min_epi64(v));
+}
+
+template<bool Max>
+inline __m512d bestAllLanes(__m512d v)
+{
+    return _mm512_set1_pd(Max ? _mm512_reduce_max_pd(v) :
+                                _mm512_reduce_min_pd(v));
+}
+
+inline unsigned eqMask(__m512i a, __m512i b)
+{
+    return _mm512_cmpeq_epi64_mask(a, b);
+}
+
+inline unsigned eqMask(__m512d a, __m512d b)
+{
+    return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ);
+}
+
+template<std::size_t Arity, bool Max, typename Vec>
+inline std::size_t
+bestKeyIndex(const char *p, Vec)
+{
+    const Vec keys0{load8Keys(p, Vec{})};
+
+    if constexpr (Arity == 8) {
+        return std::countr_zero(eqMask(keys0, bestAllLanes<Max>(keys0)));
+    }
+    else {
+        const Vec keys1{load8Keys(p + 128, Vec{})};
+        const Vec b{bestAllLanes<Max>(best<Max>(keys0, keys1))};
+
+        return std::countr_zero(eqMask(keys0, b) | (eqMask(keys1, b) << 8));
+    }
+}
+
+template<std::size_t Arity, typename Key, bool Max>
+inline std::size_t
+bestKeyIndex(const char *p)
+{
+    if constexpr (isInt64Key<Key>)
+        return bestKeyIndex<Arity, Max>(p, __m512i{});
+    else
+        return bestKeyIndex<Arity, Max>(p, __m512d{});
+}
+#elif defined(__AVX2__)
+/*
+ * gather the keys of 4 key-pointer pairs in a single register, in order
+ */
+inline __m256i
+load4Keys(const char *p, __m256i)
+{
+    const __m256i keys{_mm256_unpacklo_epi64(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32)))};
+
+    return _mm256_permute4x64_epi64(keys, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+inline __m256d
+load4Keys(const char *p, __m256d)
+{
+    const __m256d keys{_mm256_unpacklo_pd(
+        _mm256_loadu_pd(reinterpret_cast<const double *>(p)),
+        _mm256_loadu_pd(reinterpret_cast<const double *>(p + 32)))};
+
+    return _mm256_permute4x64_pd(keys, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+template<bool Max>
+inline __m256i best(__m256i a, __m256i b)
+{
+    const __m256i aGreater{_mm256_cmpgt_epi64(a, b)};
+
+    return Max ? _mm256_blendv_epi8(b, a, aGreater) :
+                 _mm256_blendv_epi8(a, b, aGreater);
+}
+
+template<bool Max>
+inline __m256d best(__m256d a, __m256d b)
+{
+    return Max ? _mm256_max_pd(a, b) : _mm256_min_pd(a, b);
+}
+
+template<bool Max>
+inline __m256i bestAllLanes(__m256i v)
+{
+    v = best<Max>(v, _mm256_permute4x64_epi64(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return best<Max>(v, _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+template<bool Max>
+inline __m256d bestAllLanes(__m256d v)
+{
+    v = best<Max>(v, _mm256_permute4x64_pd(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return best<Max>(v, _mm256_permute4x64_pd(v, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+inline unsigned eqMask(__m256i a, __m256i b)
+{
+    return static_cast<unsigned>(
+        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b))));
+}
+
+inline unsigned eqMask(__m256d a, __m256d b)
+{
+    return static_cast<unsigned>(
+        _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)));
+}
+
+template<std::size_t Arity, bool Max, typename Vec>
+inline std::size_t
+bestKeyIndex(const char *p, Vec)
+{
+    constexpr std::size_t groups{Arity / 4};
+    Vec keys[groups];
+
+    for (std::size_t i{}; i < groups; ++i)
+        keys[i] = load4Keys(p + i * 64, Vec{});
+
+    Vec b{keys[0]};
+
+    for (std::size_t i{1}; i < groups; ++i)
+        b = best<Max>(b, keys[i]);
+    b = bestAllLanes<Max>(b);
+
+    unsigned mask{};
+
+    for (std::size_t i{}; i < groups; ++i)
+        mask |= eqMask(keys[i], b) << (4 * i);
+    return std::countr_zero(mask);
+}
+
+template<std::size_t Arity, typename Key, bool Max>
+inline std::size_t
+bestKeyIndex(const char *p)
+{
+    if constexpr (isInt64Key<Key>)
+        return bestKeyIndex<Arity, Max>(p, __m256i{});
+    else
+        return bestKeyIndex<Arity, Max>(p, __m256d{});
+}
+#endif
+}
+
+template<std::size_t Arity,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename Compare>
+constexpr inline Distance
+bestChild(RandomAccessIterator first, Distance child, Distance len,
+          Compare & comp)
+{
+    Distance best{child};
+
+    if (child + static_cast<Distance>(Arity) <= len) {
+#if defined(__AVX2__)
+        if constexpr (simd::selectable<Arity, RandomAccessIterator,
+                                       Compare>::value) {
+            if (!std::is_constant_evaluated()) {
+                using Key   = typename std::iter_value_t<RandomAccessIterator>::key_type;
+                using Order = simd::keyOrder<decltype(comp.comp), Key>;
+                const char *p{reinterpret_cast<const char *>(
+                    std::to_address(first + child))};
+
+                return child + static_cast<Distance>(
+                    simd::bestKeyIndex<Arity, Key, Order::max>(p));
+            }
+        }
+#endif
+        /*
+         * all the children are present. The constant trip count lets the
+         * compiler fully unroll the scan.
+         */
+        for (std::size_t i{1}; i < Arity; ++i) {
+            const Distance cur{child + static_cast<Distance>(i)};
+
+            if (comp(*(first + best), *(first + cur)))
+                best = cur;
+        }
+    }
+    else {
+        // last parent of the heap: only len - child children
+        for (Distance cur{child + 1}; cur < len; ++cur) {
+            if (comp(*(first + best), *(first + cur)))
+                best = cur;
+        }
+    }
+    return best;
+}
+
+template<std::size_t Arity,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr void
+downheap(RandomAccessIterator first,
+         const Distance /* topIndex */, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy, top_down_sift)
+{
+    Distance child{firstChild<Arity>(k)};
+
+    // move up the best child
+    while (child < len) {
+        const Distance best{bestChild<Arity>(first, child, len, comp)};
+
+        if (!comp(v, *(first + best)))
+            break;
+        policy.onLevel();
+        place(first, k, std::move(*(first + best)), policy);
+        k     = best;
+        child = firstChild<Arity>(k);
+    }
+    place(first, k, std::move(v), policy);
+}
+
+template<std::size_t Arity,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr void
+downheap(RandomAccessIterator first,
+         const Distance topIndex, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy, bottom_up_sift)
+{
+    Distance child{firstChild<Arity>(k)};
+
+    // move the hole down to a leaf
+    while (child < len) {
+        const Distance best{bestChild<Arity>(first, child, len, comp)};
+
+        policy.onLevel();
+        place(first, k, std::move(*(first + best)), policy);
+        k     = best;
+        child = firstChild<Arity>(k);
+    }
+    upheap<Arity>(first, k, topIndex, std::move(v), comp, policy);
+}
+
+template<std::size_t Arity,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         HeapPolicy Policy>
+constexpr inline void
+downheap(RandomAccessIterator first,
+         const Distance topIndex, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy)
+{
+    downheap<Arity>(first, topIndex, k, len, std::move(v), comp, policy,
+                    typename Policy::sift_strategy{});
+}
+
+/*
+ * downheap used while building the heap. Positions are not recorded since
+ * the element may move again before the heap is complete.
+ */
+template<std::size_t Arity,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr void
+siftdown(RandomAccessIterator first,
+         Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy)
+{
+    Distance child{firstChild<Arity>(k)};
+
+    while (child < len) {
+        const Distance best{bestChild<Arity>(first, child, len, comp)};
+
+        if (!comp(v, *(first + best)))
+            break;
+        policy.onLevel();
+        *(first + k) = std::move(*(first + best));
+        policy.onMove();
+        k     = best;
+        child = firstChild<Arity>(k);
+    }
+    *(first + k) = std::move(v);
+    policy.onMove();
+}
+
+template<std::size_t Arity,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr inline void
+adjust(RandomAccessIterator first, Distance k, Distance len,
+       itemType v, Compare & comp, Policy & policy)
+{
+    if (k > 0 && comp(*(first + parent<Arity>(k)), v))
+        upheap<Arity>(first, k, Distance{}, std::move(v), comp, policy);
+    else
+        downheap<Arity>(first, k, // v cannot go above k
+                        k, len, std::move(v), comp, policy);
+}
+
+template<std::size_t Arity, typename RandomAccessIterator,
+         typename Compare, typename Policy>
+constexpr inline void
+remove(RandomAccessIterator first, RandomAccessIterator last,
+       RandomAccessIterator popPos, RandomAccessIterator result,
+       Compare& comp, Policy & policy)
+{
+    using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    if (popPos == result)
+        return;
+
+    /*
+     * previous smallest priority element is stored in v
+     * to be repositioned.
+     */
+    ValueType v{std::move(*result)};
+
+    // popPos is going to be popped
+    *result = std::move(*popPos);
+    policy.onMove();
+
+    adjust<Arity>(first,
+                  DistanceType{popPos - first}, // k
+                  DistanceType(last - first),   // len
+                  std::move(v), comp, policy);
+}
+}
+
+/**
+ *  @brief  Find the end of the valid part of an indirect d-ary heap.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return The first element that breaks the heap condition or whose
+ *          recorded position is not its slot, last if there is none.
+ *  @ingroup heap_algorithms
+ *
+ *  d-ary counterpart of Base::is_heap_until().
+ */
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr RandomAccessIterator
+is_heap_until(RandomAccessIterator first, RandomAccessIterator last,
+              Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    const DistanceType len{last - first};
+
+    for (DistanceType k{}; k < len; ++k) {
+        const auto &e{*(first + k)};
+
+        if (static_cast<DistanceType>(Base::HeapHelpers::storedHeapIndex(e, policy)) != k ||
+            (k > 0 && comp(*(first + HeapHelpers::parent<Arity>(k)), e)))
+            return first + k;
+    }
+    return last;
+}
+
+namespace HeapHelpers {
+/*
+ * end of a mutation leaving the d-ary heap [first,last)
+ */
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         typename Policy>
+constexpr inline void
+endOp(RandomAccessIterator first, RandomAccessIterator last, Compare & comp,
+      Policy & policy)
+{
+    Base::HeapHelpers::endOpWith(
+        first, last,
+        [&comp, &policy](auto f, auto l) {
+            return dary::is_heap_until<Arity>(f, l, comp, policy);
+        },
+        policy);
+}
+}
+
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+upheap(RandomAccessIterator first, RandomAccessIterator last,
+       RandomAccessIterator changed, Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    ValueType v = std::move(*changed);
+
+    HeapHelpers::upheap<Arity>(first,                         // first
+                               DistanceType(changed - first), // k
+                               DistanceType{},                // top index
+                               std::move(v), c, policy);
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+}
+
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+downheap(RandomAccessIterator first, RandomAccessIterator last,
+         RandomAccessIterator changed, Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    ValueType v = std::move(*changed);
+
+    HeapHelpers::downheap<Arity>(first, DistanceType{},         // topIndex
+                                 DistanceType{changed - first}, // k
+                                 DistanceType(last - first),    // len
+                                 std::move(v), c, policy);
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+}
+
+namespace HeapHelpers {
+template<std::size_t Arity, typename RandomAccessIterator,
+         typename Compare, typename Policy>
+constexpr inline void
+update(RandomAccessIterator first, RandomAccessIterator last,
+       RandomAccessIterator changed, Compare & comp, Policy & policy)
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    ValueType v = std::move(*changed);
+
+    adjust<Arity>(first,
+                  DistanceType{changed - first}, // k
+                  DistanceType(last - first),    // len
+                  std::move(v), comp, policy);
+}
+}
+
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+update_heap(RandomAccessIterator first, RandomAccessIterator last,
+            RandomAccessIterator changed, Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    HeapHelpers::update<Arity>(first, last, changed, c, policy);
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+}
+
+template<std::size_t Arity, typename RandomAccessIterator, typename Key,
+         typename Compare, HeapPolicy Policy = default_policy>
+constexpr inline void
+update_key(RandomAccessIterator first, RandomAccessIterator last,
+           RandomAccessIterator changed, Key &&key, Compare comp,
+           Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    (*changed).key = std::forward<Key>(key);
+    HeapHelpers::update<Arity>(first, last, changed, c, policy);
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Push an element onto a d-ary heap using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap + element.
+ *  @param  comp   Comparison functor.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  d-ary counterpart of Base::push_heap().
+*/
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+push_heap(RandomAccessIterator first, RandomAccessIterator last,
+          Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::push);
+    ValueType v = std::move(*(last - 1));
+
+    HeapHelpers::upheap<Arity>(first, DistanceType((last - 1) - first), // k
+                               DistanceType{},                 // top index
+                               std::move(v), c, policy);
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Pop an element off a d-ary heap using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  d-ary counterpart of Base::pop_heap().
+ */
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+pop_heap(RandomAccessIterator first,
+         RandomAccessIterator last, Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::pop);
+    if (last - first > 1) {
+        --last;
+        HeapHelpers::remove<Arity>(first, last, first, last, c, policy);
+    }
+    else {
+        last = first;
+    }
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+}
+
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+pop_heap(RandomAccessIterator first, RandomAccessIterator last,
+         RandomAccessIterator popPos,
+         Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::erase);
+    if (last - first > 1) {
+        --last;
+        HeapHelpers::remove<Arity>(first, last, popPos, last, c, policy);
+    }
+    else {
+        last = first;
+    }
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Replace the top of a d-ary heap by a new element.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  v      New element.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return The former top.
+ *  @ingroup heap_algorithms
+ *
+ *  d-ary counterpart of Base::replace_top().
+ */
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline typename std::iterator_traits<RandomAccessIterator>::value_type
+replace_top(RandomAccessIterator first, RandomAccessIterator last,
+            typename std::iterator_traits<RandomAccessIterator>::value_type v,
+            Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::replace);
+    ValueType top{std::move(*first)};
+
+    HeapHelpers::downheap<Arity>(first, DistanceType{},      // topIndex
+                                 DistanceType{},             // k
+                                 DistanceType(last - first), // len
+                                 std::move(v), c, policy);
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+    return top;
+}
+
+/*
+ * replace the element at pos by v and return it. v is sifted in whichever
+ * direction it belongs.
+ */
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline typename std::iterator_traits<RandomAccessIterator>::value_type
+replace_at(RandomAccessIterator first, RandomAccessIterator last,
+           RandomAccessIterator pos,
+           typename std::iterator_traits<RandomAccessIterator>::value_type v,
+           Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::replace);
+    ValueType old{std::move(*pos)};
+
+    HeapHelpers::adjust<Arity>(first,
+                               DistanceType{pos - first},  // k
+                               DistanceType(last - first), // len
+                               std::move(v), c, policy);
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+    return old;
+}
+
+/*
+ * push v and pop the top in a single sift. v itself is returned, without
+ * touching the heap nor recording a position, when it would be the new
+ * top.
+ */
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline typename std::iterator_traits<RandomAccessIterator>::value_type
+push_pop_heap(RandomAccessIterator first, RandomAccessIterator last,
+              typename std::iterator_traits<RandomAccessIterator>::value_type v,
+              Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::replace);
+    if (first == last || !c(v, *first)) {
+        HeapHelpers::endOp<Arity>(first, last, comp, policy);
+        return v;
+    }
+
+    ValueType top{std::move(*first)};
+
+    HeapHelpers::downheap<Arity>(first, DistanceType{},      // topIndex
+                                 DistanceType{},             // k
+                                 DistanceType(last - first), // len
+                                 std::move(v), c, policy);
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+    return top;
+}
+
+/**
+ *  @brief  Construct a d-ary heap over a range using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  d-ary counterpart of Base::make_heap(). Base::make_heap_sorted() is
+ *  also valid for d-ary heaps.
+ */
+template<std::size_t Arity, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr void
+make_heap(RandomAccessIterator first, RandomAccessIterator last,
+          Compare comp, Policy policy = {})
+{
+    static_assert(Arity >= 2, "a heap node must have at least 2 children");
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    const DistanceType len{last - first};
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::make);
+    if (len > 1) {
+        for (DistanceType k{HeapHelpers::parent<Arity>(len - 1)}; k >= 0; --k) {
+            ValueType v = std::move(*(first + k));
+
+            HeapHelpers::siftdown<Arity>(first, k, len, std::move(v), c,
+                                         policy);
+        }
+    }
+    Base::HeapHelpers::setHeapIndexes(first, last, policy);
+    HeapHelpers::endOp<Arity>(first, last, comp, policy);
+}
+}
+
+/*
+ * B-heap variant of the indirect heap algorithms
+ *
+ * binary heap whose nodes are laid out in blocks of 2^Levels - 1 slots.
+ * Every block holds a complete subtree of Levels levels and the children
+ * of the leaves of a block are the roots of 2^Levels other blocks:
+ *
+ * Base::bheap::push_heap<9>(first, last, comp);
+ *
+ * A sift then crosses a block boundary only once every Levels levels
+ * instead of touching a different page at every level once the heap
+ * outgrows the caches. ie: with 8 bytes elements, Levels = 9 fits a
+ * block in a 4KB page (it straddles at most 2 pages when the array is
+ * not page aligned) and Levels = 3 fits one in a cache line.
+ *
+ * Same interface and heap condition as the binary algorithms, except that
+ * the parent/child relation follows the blocked layout, so the range is
+ * not a std heap. The positions given to setHeapIndex() are still the
+ * element slots in the range, usable to locate an element in O(1).
+ * Elements fill the slots in order so removing the last element keeps
+ * the tree shape. Levels = 1 is the plain binary heap layout.
+ */
+namespace bheap {
+namespace HeapHelpers {
+template<std::size_t Levels>
+struct layout
+{
+    static_assert(Levels >= 1 && Levels < 16, "unsupported block height");
+
+    static constexpr std::size_t BlockSize = (std::size_t{1} << Levels) - 1;
+    // blocks below a block
+    static constexpr std::size_t Fanout    = BlockSize + 1;
+    // slot of the first leaf in a block
+    static constexpr std::size_t FirstLeaf = (std::size_t{1} << (Levels - 1)) - 1;
+
+    template<typename Distance>
+    static constexpr Distance parent(Distance k)
+    {
+        constexpr Distance B{static_cast<Distance>(BlockSize)};
+        const Distance block{k / B};
+        const Distance slot{k % B};
+
+        if (slot > 0)
+            return block * B + (slot - 1) / 2;
+
+        // block root: its parent is a leaf of the parent block
+        constexpr Distance F{static_cast<Distance>(Fanout)};
+        const Distance child{block - 1};
+
+        return (child / F) * B + static_cast<Distance>(FirstLeaf) +
+               (child % F) / 2;
+    }
+
+    /*
+     * 2 children of k are firstChild(k) and firstChild(k) + childStep(k)
+     */
+    template<typename Distance>
+    static constexpr Distance firstChild(Distance k)
+    {
+        constexpr Distance B{static_cast<Distance>(BlockSize)};
+        const Distance block{k / B};
+        const Distance slot{k % B};
+
+        if (slot < static_cast<Distance>(FirstLeaf))
+            return block * B + 2 * slot + 1;
+        return (block * static_cast<Distance>(Fanout) + 1 +
+                2 * (slot - static_cast<Distance>(FirstLeaf))) * B;
+    }
+
+    template<typename Distance>
+    static constexpr Distance childStep(Distance k)
+    {
+        constexpr Distance B{static_cast<Distance>(BlockSize)};
+
+        return k % B < static_cast<Distance>(FirstLeaf) ? 1 : B;
+    }
+};
+
+using Base::HeapHelpers::place;
+
+template<std::size_t Levels,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr void
+upheap(RandomAccessIterator first,
+       Distance k,
+       Distance topIndex,
+       itemType v, Compare & comp, Policy & policy)
+{
+    using L = layout<Levels>;
+
+    while (k > topIndex) { // sentinel
+        const Distance p{L::parent(k)};
+
+        if (!comp(*(first + p), v)) // if v is not greater (if comp is less)
+            break;
+        policy.onLevel();
+        // move down the parent
+        place(first, k, std::move(*(first + p)), policy);
+        k = p;
+    }
+    place(first, k, std::move(v), policy);
+}
+
+/*
+ * best child of k. k must have at least one child.
+ */
+template<std::size_t Levels,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename Compare>
+constexpr inline Distance
+bestChild(RandomAccessIterator first, Distance k, Distance len,
+          Compare & comp)
+{
+    using L = layout<Levels>;
+    const Distance child{L::firstChild(k)};
+    const Distance second{child + L::childStep(k)};
+
+    if (second < len && comp(*(first + child), *(first + second)))
+        return second;
+    return child;
+}
+
+template<std::size_t Levels,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr void
+downheap(RandomAccessIterator first,
+         const Distance /* topIndex */, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy, top_down_sift)
+{
+    using L = layout<Levels>;
+
+    // move up the best child
+    while (L::firstChild(k) < len) {
+        const Distance best{bestChild<Levels>(first, k, len, comp)};
+
+        if (!comp(v, *(first + best)))
+            break;
+        policy.onLevel();
+        place(first, k, std::move(*(first + best)), policy);
+        k = best;
+    }
+    place(first, k, std::move(v), policy);
+}
+
+template<std::size_t Levels,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr void
+downheap(RandomAccessIterator first,
+         const Distance topIndex, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy, bottom_up_sift)
+{
+    using L = layout<Levels>;
+
+    // move the hole down to a leaf
+    while (L::firstChild(k) < len) {
+        const Distance best{bestChild<Levels>(first, k, len, comp)};
+
+        policy.onLevel();
+        place(first, k, std::move(*(first + best)), policy);
+        k = best;
+    }
+    upheap<Levels>(first, k, topIndex, std::move(v), comp, policy);
+}
+
+template<std::size_t Levels,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         HeapPolicy Policy>
+constexpr inline void
+downheap(RandomAccessIterator first,
+         const Distance topIndex, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy)
+{
+    downheap<Levels>(first, topIndex, k, len, std::move(v), comp, policy,
+                     typename Policy::sift_strategy{});
+}
+
+/*
+ * downheap used while building the heap. Positions are not recorded since
+ * the element may move again before the heap is complete.
+ */
+template<std::size_t Levels,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr void
+siftdown(RandomAccessIterator first,
+         Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy)
+{
+    using L = layout<Levels>;
+
+    while (L::firstChild(k) < len) {
+        const Distance best{bestChild<Levels>(first, k, len, comp)};
+
+        if (!comp(v, *(first + best)))
+            break;
+        policy.onLevel();
+        *(first + k) = std::move(*(first + best));
+        policy.onMove();
+        k = best;
+    }
+    *(first + k) = std::move(v);
+    policy.onMove();
+}
+
+template<std::size_t Levels,
+         typename RandomAccessIterator,
+         typename Distance,
+         typename itemType,
+         typename Compare,
+         typename Policy>
+constexpr inline void
+adjust(RandomAccessIterator first, Distance k, Distance len,
+       itemType v, Compare & comp, Policy & policy)
+{
+    if (k > 0 && comp(*(first + layout<Levels>::parent(k)), v))
+        upheap<Levels>(first, k, Distance{}, std::move(v), comp, policy);
+    else
+        downheap<Levels>(first, k, // v cannot go above k
+                         k, len, std::move(v), comp, policy);
+}
+
+template<std::size_t Levels, typename RandomAccessIterator,
+         typename Compare, typename Policy>
+constexpr inline void
+remove(RandomAccessIterator first, RandomAccessIterator last,
+       RandomAccessIterator popPos, RandomAccessIterator result,
+       Compare& comp, Policy & policy)
+{
+    using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+
+    // popping the last element leaves the rest of the heap untouched
+    if (popPos == result)
+        return;
+
+    /*
+     * previous smallest priority element is stored in v
+     * to be repositioned.
+     */
+    ValueType v{std::move(*result)};
+
+    // popPos is going to be popped
+    *result = std::move(*popPos);
+    policy.onMove();
+
+    adjust<Levels>(first,
+                   DistanceType{popPos - first}, // k
+                   DistanceType(last - first),   // len
+                   std::move(v), comp, policy);
+}
+
+template<std::size_t Levels, typename RandomAccessIterator,
+         typename Compare, typename Policy>
+constexpr inline void
+update(RandomAccessIterator first, RandomAccessIterator last,
+       RandomAccessIterator changed, Compare & comp, Policy & policy)
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    ValueType v = std::move(*changed);
+
+    adjust<Levels>(first,
+                   DistanceType{changed - first}, // k
+                   DistanceType(last - first),    // len
+                   std::move(v), comp, policy);
+}
+}
+
+/**
+ *  @brief  Find the end of the valid part of an indirect B-heap.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return The first element that breaks the heap condition or whose
+ *          recorded position is not its slot, last if there is none.
+ *  @ingroup heap_algorithms
+ *
+ *  B-heap counterpart of Base::is_heap_until().
+ */
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr RandomAccessIterator
+is_heap_until(RandomAccessIterator first, RandomAccessIterator last,
+              Compare comp, Policy policy = {})
+{
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    using L            = HeapHelpers::layout<Levels>;
+    const DistanceType len{last - first};
+
+    for (DistanceType k{}; k < len; ++k) {
+        const auto &e{*(first + k)};
+
+        if (static_cast<DistanceType>(Base::HeapHelpers::storedHeapIndex(e, policy)) != k ||
+            (k > 0 && comp(*(first + L::parent(k)), e)))
+            return first + k;
+    }
+    return last;
+}
+
+namespace HeapHelpers {
+/*
+ * end of a mutation leaving the B-heap [first,last)
+ */
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         typename Policy>
+constexpr inline void
+endOp(RandomAccessIterator first, RandomAccessIterator last, Compare & comp,
+      Policy & policy)
+{
+    Base::HeapHelpers::endOpWith(
+        first, last,
+        [&comp, &policy](auto f, auto l) {
+            return bheap::is_heap_until<Levels>(f, l, comp, policy);
+        },
+        policy);
+}
+}
 
 /*
- * uncomment to preserve the heap elements stability. Preserving stability
- * increases the number of operations to fix the heap conditions violation
- * following a removal or a deletion.
+ * restore the heap condition after the priority of the changed element has
+ * been modified in either direction.
+ */
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+update_heap(RandomAccessIterator first, RandomAccessIterator last,
+            RandomAccessIterator changed, Compare comp, Policy policy = {})
+{
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    HeapHelpers::update<Levels>(first, last, changed, c, policy);
+    HeapHelpers::endOp<Levels>(first, last, comp, policy);
+}
+
+template<std::size_t Levels, typename RandomAccessIterator, typename Key,
+         typename Compare, HeapPolicy Policy = default_policy>
+constexpr inline void
+update_key(RandomAccessIterator first, RandomAccessIterator last,
+           RandomAccessIterator changed, Key &&key, Compare comp,
+           Policy policy = {})
+{
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
+    (*changed).key = std::forward<Key>(key);
+    HeapHelpers::update<Levels>(first, last, changed, c, policy);
+    HeapHelpers::endOp<Levels>(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Push an element onto a B-heap using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap + element.
+ *  @param  comp   Comparison functor.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  B-heap counterpart of Base::push_heap().
+*/
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+push_heap(RandomAccessIterator first, RandomAccessIterator last,
+          Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::push);
+    ValueType v = std::move(*(last - 1));
+
+    HeapHelpers::upheap<Levels>(first, DistanceType((last - 1) - first), // k
+                                DistanceType{},                 // top index
+                                std::move(v), c, policy);
+    HeapHelpers::endOp<Levels>(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Pop an element off a B-heap using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  B-heap counterpart of Base::pop_heap().
+ */
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+pop_heap(RandomAccessIterator first,
+         RandomAccessIterator last, Compare comp, Policy policy = {})
+{
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::pop);
+    if (last - first > 1) {
+        --last;
+        HeapHelpers::remove<Levels>(first, last, first, last, c, policy);
+    }
+    else {
+        last = first;
+    }
+    HeapHelpers::endOp<Levels>(first, last, comp, policy);
+}
+
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+pop_heap(RandomAccessIterator first, RandomAccessIterator last,
+         RandomAccessIterator popPos,
+         Compare comp, Policy policy = {})
+{
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::erase);
+    if (last - first > 1) {
+        --last;
+        HeapHelpers::remove<Levels>(first, last, popPos, last, c, policy);
+    }
+    else {
+        last = first;
+    }
+    HeapHelpers::endOp<Levels>(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Replace the top of a B-heap by a new element.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  v      New element.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return The former top.
+ *  @ingroup heap_algorithms
+ *
+ *  B-heap counterpart of Base::replace_top().
  */
-//#define BASE_HEAP_PRESERVE_STABILITY 1
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline typename std::iterator_traits<RandomAccessIterator>::value_type
+replace_top(RandomAccessIterator first, RandomAccessIterator last,
+            typename std::iterator_traits<RandomAccessIterator>::value_type v,
+            Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
 
-namespace Base {
+    policy.beginOp(heap_op::replace);
+    ValueType top{std::move(*first)};
+
+    HeapHelpers::downheap<Levels>(first, DistanceType{},      // topIndex
+                                  DistanceType{},             // k
+                                  DistanceType(last - first), // len
+                                  std::move(v), c, policy);
+    HeapHelpers::endOp<Levels>(first, last, comp, policy);
+    return top;
+}
 
 /*
- * the root of the heap is the highest priority element
- * when an element is popped, it is the first element is moved in the last
- * element and the last element is placed in its right place by calling
- * downheap.
+ * replace the element at pos by v and return it. v is sifted in whichever
+ * direction it belongs.
  */
-namespace HeapHelpers {
-template<typename RandomAccessIterator,
-         typename Distance,
-         typename itemType,
-         typename Compare>
-constexpr void
-upheap(RandomAccessIterator first,
-       Distance k,
-       Distance topIndex,
-       itemType v, Compare & comp)
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline typename std::iterator_traits<RandomAccessIterator>::value_type
+replace_at(RandomAccessIterator first, RandomAccessIterator last,
+           RandomAccessIterator pos,
+           typename std::iterator_traits<RandomAccessIterator>::value_type v,
+           Compare comp, Policy policy = {})
 {
-    Distance parent{(k - 1) / 2};
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
 
-    while (k > topIndex && // sentinel
-           comp(*(first + parent), v)) { // if v is greater (if comp is less)
-        auto it{first + k};
+    policy.beginOp(heap_op::replace);
+    ValueType old{std::move(*pos)};
 
-        // move down the parent
-        *(it) = std::move(*(first + parent));
-        setHeapIndex(*it, k);
-        k = parent;
-        parent = (k - 1) / 2;
+    HeapHelpers::adjust<Levels>(first,
+                                DistanceType{pos - first},  // k
+                                DistanceType(last - first), // len
+                                std::move(v), c, policy);
+    HeapHelpers::endOp<Levels>(first, last, comp, policy);
+    return old;
+}
+
+/*
+ * push v and pop the top in a single sift. v itself is returned, without
+ * touching the heap nor recording a position, when it would be the new
+ * top.
+ */
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline typename std::iterator_traits<RandomAccessIterator>::value_type
+push_pop_heap(RandomAccessIterator first, RandomAccessIterator last,
+              typename std::iterator_traits<RandomAccessIterator>::value_type v,
+              Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::replace);
+    if (first == last || !c(v, *first)) {
+        HeapHelpers::endOp<Levels>(first, last, comp, policy);
+        return v;
     }
-    auto it{first + k};
 
-    *(it) = std::move(v);
-    setHeapIndex(*it, k);
+    ValueType top{std::move(*first)};
+
+    HeapHelpers::downheap<Levels>(first, DistanceType{},      // topIndex
+                                  DistanceType{},             // k
+                                  DistanceType(last - first), // len
+                                  std::move(v), c, policy);
+    HeapHelpers::endOp<Levels>(first, last, comp, policy);
+    return top;
 }
 
-template<typename RandomAccessIterator, typename Distance,
-         typename itemType, typename Compare>
+/**
+ *  @brief  Construct a B-heap over a range using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  B-heap counterpart of Base::make_heap(). Base::make_heap_sorted() is
+ *  also valid for B-heaps.
+ */
+template<std::size_t Levels, typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
 constexpr void
-downheap(RandomAccessIterator first,
-         const Distance topIndex, Distance k, Distance len,
-         itemType v, Compare comp)
+make_heap(RandomAccessIterator first, RandomAccessIterator last,
+          Compare comp, Policy policy = {})
 {
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    const DistanceType len{last - first};
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::make);
     /*
-     * initialize secondChild with k to start inspecting its children in the
-     * following loop
+     * a node slot is always lower than its children slots but the last
+     * parent is not necessarily the parent of the last element: every
+     * slot that can have a child is sifted.
      */
-    Distance secondChild = k;
+    for (DistanceType k{len - 2}; k >= 0; --k) {
+        if (HeapHelpers::layout<Levels>::firstChild(k) < len) {
+            ValueType v = std::move(*(first + k));
 
-    // move up the best child
-    while (secondChild < (len - 1) / 2) {
-        secondChild = 2 * (secondChild + 1);
-        // pick the biggest child
-        if (comp(*(first + secondChild),
-                 *(first + (secondChild - 1))))
-            --secondChild;
-#ifndef BASE_HEAP_PRESERVE_STABILITY
-        if (!comp(v, *(first + secondChild)))
+            HeapHelpers::siftdown<Levels>(first, k, len, std::move(v), c,
+                                          policy);
+        }
+    }
+    Base::HeapHelpers::setHeapIndexes(first, last, policy);
+    HeapHelpers::endOp<Levels>(first, last, comp, policy);
+}
+}
+
+/*
+ * min-max variant of the indirect heap algorithms
+ *
+ * M. D. Atkinson, J.-R. Sack, N. Santoro, T. Strothotte.
+ * Min-Max Heaps and Generalized Priority Queues (1986)
+ *
+ * double-ended heap: the levels alternate between max levels, where a node
+ * has a higher priority than its descendants, and min levels, where it has
+ * a lower one. The root is on a max level so *first is still the highest
+ * priority element and the lowest one is one of its children:
+ *
+ * Base::minmax::push_heap(first, last, comp);
+ * Base::minmax::pop_min(first, last, comp); // ie: latest deadline
+ *
+ * A single position is recorded per element for both ends, instead of one
+ * per heap with twin min and max heaps. The sifts move along the
+ * grandparent links: a pop from either end of n elements costs about
+ * log2(n)/2 moves, half of a binary heap pop, but 3.5 comparisons per
+ * level instead of 2. The sift strategy of the policy is ignored.
+ */
+namespace minmax {
+namespace HeapHelpers {
+using Base::HeapHelpers::depth;
+using Base::HeapHelpers::place;
+
+template<typename Distance>
+constexpr inline bool
+isMaxLevel(Distance k)
+{
+    return (depth(k) & 1) == 0;
+}
+
+/*
+ * true when a belongs above b on a level of the Max kind
+ */
+template<bool Max, typename Compare, typename Lhs, typename Rhs>
+constexpr inline bool
+above(Compare & comp, const Lhs & a, const Rhs & b)
+{
+    if constexpr (Max)
+        return comp(b, a);
+    else
+        return comp(a, b);
+}
+
+/*
+ * store v in the slot k. Positions are not recorded while the heap is
+ * built since the element may move again before the heap is complete.
+ */
+template<bool Record, typename RandomAccessIterator, typename Distance,
+         typename itemType, typename Policy>
+constexpr inline void
+store(RandomAccessIterator first, Distance k, itemType &&v, Policy & policy)
+{
+    if constexpr (Record) {
+        place(first, k, std::forward<itemType>(v), policy);
+    }
+    else {
+        *(first + k) = std::forward<itemType>(v);
+        policy.onMove();
+    }
+}
+
+/*
+ * move v up the levels of the Max kind above k
+ */
+template<bool Max, typename RandomAccessIterator, typename Distance,
+         typename itemType, typename Compare, typename Policy>
+constexpr void
+upheap(RandomAccessIterator first, Distance k, itemType v,
+       Compare & comp, Policy & policy)
+{
+    while (k > 2) { // k has a grandparent
+        const Distance grandparent{((k - 1) / 2 - 1) / 2};
+
+        if (!above<Max>(comp, v, *(first + grandparent)))
             break;
-#endif
-        auto it{first + k};
+        policy.onLevel();
+        // move down the grandparent
+        place(first, k, std::move(*(first + grandparent)), policy);
+        k = grandparent;
+    }
+    place(first, k, std::move(v), policy);
+}
 
-        *(it) = std::move(*(first + secondChild));
-        setHeapIndex(*it, k);
-        k = secondChild;
+/*
+ * sift v down from the slot k, on a level of the Max kind.
+ */
+template<bool Max, bool Record = true, typename RandomAccessIterator,
+         typename Distance, typename itemType, typename Compare,
+         typename Policy>
+constexpr void
+downheap(RandomAccessIterator first, Distance k, Distance len,
+         itemType v, Compare & comp, Policy & policy)
+{
+    for (;;) {
+        const Distance child{2 * k + 1};
+
+        if (child >= len)
+            break;
+
+        // best of the children and grandchildren
+        Distance best{child};
+
+        if (child + 1 < len && above<Max>(comp, *(first + (child + 1)), *(first + best)))
+            best = child + 1;
+
+        const Distance grandchild{2 * child + 1};
+        const Distance lastGrandchild{std::min(grandchild + 4, len)};
+
+        for (Distance g{grandchild}; g < lastGrandchild; ++g) {
+            if (above<Max>(comp, *(first + g), *(first + best)))
+                best = g;
+        }
+        if (!above<Max>(comp, *(first + best), v))
+            break;
+        policy.onLevel();
+        store<Record>(first, k, std::move(*(first + best)), policy);
+        k = best;
+        /*
+         * a child is on the other kind of level and has a lower priority
+         * than its descendants (on a max level k). v belongs there.
+         */
+        if (best < grandchild)
+            break;
+
+        // v must not pass its new parent on the other kind of level
+        const Distance parent{(best - 1) / 2};
+
+        if (above<!Max>(comp, v, *(first + parent))) {
+            itemType w{std::move(*(first + parent))};
+
+            store<Record>(first, parent, std::move(v), policy);
+            v = std::move(w);
+        }
     }
-#ifndef BASE_HEAP_PRESERVE_STABILITY
-    auto it{first + k};
+    store<Record>(first, k, std::move(v), policy);
+}
 
-    *(it) = std::move(v);
-    setHeapIndex(*it, k);
-#else
-    /*
-     * if heap size is odd
-     * and secondchild points on the leaves on the previous generation:
-     * ie: len=15, secondChild=6,
-     *
-     * place the last heap element in the previous generation unique leaf
-     * so that the upheap starts on the latest generation.
-     */
-    if ((len & 1) == 0 &&
-        secondChild == (len - 2) / 2) {
-        secondChild = 2 * (secondChild + 1);
-        const auto secondChildIdx{secondChild - 1};
-        auto it{first + k};
+/*
+ * place v in the slot k, on a level of the Max kind, and restore the heap
+ * condition in whichever direction it belongs.
+ */
+template<bool Max, typename RandomAccessIterator, typename Distance,
+         typename itemType, typename Compare, typename Policy>
+constexpr void
+adjust(RandomAccessIterator first, Distance k, Distance len,
+       itemType v, Compare & comp, Policy & policy)
+{
+    if (k > 0) {
+        const Distance parent{(k - 1) / 2};
 
-        *(it) = std::move(*(first + secondChildIdx));
-        setHeapIndex(*it, k);
-        k = secondChildIdx;
+        if (above<!Max>(comp, v, *(first + parent))) {
+            /*
+             * v passes its parent on the other kind of level. The parent
+             * comes down in the slot k and v goes up the levels of the
+             * parent kind.
+             */
+            itemType w{std::move(*(first + parent))};
+
+            upheap<!Max>(first, parent, std::move(v), comp, policy);
+            downheap<Max>(first, k, len, std::move(w), comp, policy);
+            return;
+        }
+        if (k > 2 && above<Max>(comp, v, *(first + (parent - 1) / 2))) {
+            upheap<Max>(first, k, std::move(v), comp, policy);
+            return;
+        }
     }
+    downheap<Max>(first, k, len, std::move(v), comp, policy);
+}
 
-    /*
-     * at this point, k points to the hole, upheap the heap
-     * with v from this point.
-     *
-     * NOTE:.
-     * this is done to preserve stability.
-     */
-    upheap(first, k, topIndex, std::move(v), comp);
-#endif
+template<typename RandomAccessIterator, typename Distance,
+         typename itemType, typename Compare, typename Policy>
+constexpr inline void
+adjust(RandomAccessIterator first, Distance k, Distance len,
+       itemType v, Compare & comp, Policy & policy)
+{
+    if (isMaxLevel(k))
+        adjust<true>(first, k, len, std::move(v), comp, policy);
+    else
+        adjust<false>(first, k, len, std::move(v), comp, policy);
 }
 
-template<typename RandomAccessIterator, typename Compare>
+/*
+ * slot of the lowest priority element. len must be at least 1.
+ */
+template<typename RandomAccessIterator, typename Distance, typename Compare>
+constexpr inline Distance
+minIndex(RandomAccessIterator first, Distance len, Compare & comp)
+{
+    if (len < 3)
+        return len - 1;
+    return comp(*(first + 2), *(first + 1)) ? 2 : 1;
+}
+
+template<typename RandomAccessIterator, typename Compare, typename Policy>
 constexpr inline void
 remove(RandomAccessIterator first, RandomAccessIterator last,
        RandomAccessIterator popPos, RandomAccessIterator result,
-       Compare& comp)
+       Compare& comp, Policy & policy)
 {
     using ValueType = typename std::iterator_traits<RandomAccessIterator>::value_type;
     using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
 
+    // popping the last element leaves the rest of the heap untouched
+    if (popPos == result)
+        return;
+
     /*
-     * previous smallest priority element is stored in v
-     * to be repositioned.
+     * previous last element is stored in v to be repositioned.
      */
     ValueType v{std::move(*result)};
 
     // popPos is going to be popped
     *result = std::move(*popPos);
+    policy.onMove();
 
-    downheap(first, DistanceType{},        // topIndex
-             DistanceType{popPos - first}, // k
-             DistanceType(last - first),   // len
-             std::move(v), comp);
+    // qualified: the instrumented comparator would find the binary heap one
+    minmax::HeapHelpers::adjust(first,
+                                DistanceType{popPos - first}, // k
+                                DistanceType(last - first),   // len
+                                std::move(v), comp, policy);
 }
 }
 
-template<typename RandomAccessIterator, typename Compare>
-constexpr inline void
-upheap(RandomAccessIterator first, RandomAccessIterator last,
-       RandomAccessIterator changed, Compare comp)
+/**
+ *  @brief  Find the end of the valid part of an indirect min-max heap.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @return The first element that breaks the min-max heap condition or
+ *          whose recorded position is not its slot, last if there is none.
+ *  @ingroup heap_algorithms
+ *
+ *  An element is checked against its parent, on the other kind of level,
+ *  and its grandparent, on the same kind, which is enough for the whole
+ *  heap. Min-max counterpart of Base::is_heap_until().
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr RandomAccessIterator
+is_heap_until(RandomAccessIterator first, RandomAccessIterator last,
+              Compare comp, Policy policy = {})
 {
-    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
     using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
-    ValueType v = std::move(*changed);
+    const DistanceType len{last - first};
 
-    HeapHelpers::upheap(first,                         // first
-                        DistanceType(changed - first), // k
-                        DistanceType{},                // top index
-                        std::move(v), comp);
+    for (DistanceType k{}; k < len; ++k) {
+        const auto &e{*(first + k)};
+
+        if (static_cast<DistanceType>(Base::HeapHelpers::storedHeapIndex(e, policy)) != k)
+            return first + k;
+        if (k == 0)
+            continue;
+
+        const DistanceType parent{(k - 1) / 2};
+        const bool         max{HeapHelpers::isMaxLevel(k)};
+
+        if (max ? comp(e, *(first + parent)) : comp(*(first + parent), e))
+            return first + k;
+        if (k > 2) {
+            const DistanceType grandparent{(parent - 1) / 2};
+
+            if (max ? comp(*(first + grandparent), e) : comp(e, *(first + grandparent)))
+                return first + k;
+        }
+    }
+    return last;
+}
+
+namespace HeapHelpers {
+/*
+ * end of a mutation leaving the min-max heap [first,last)
+ */
+template<typename RandomAccessIterator, typename Compare, typename Policy>
+constexpr inline void
+endOp(RandomAccessIterator first, RandomAccessIterator last, Compare & comp,
+      Policy & policy)
+{
+    Base::HeapHelpers::endOpWith(
+        first, last,
+        [&comp, &policy](auto f, auto l) {
+            return minmax::is_heap_until(f, l, comp, policy);
+        },
+        policy);
+}
 }
 
+/*
+ * lowest priority element of the min-max heap [first,last)
+ */
 template<typename RandomAccessIterator, typename Compare>
+constexpr inline RandomAccessIterator
+min_element(RandomAccessIterator first, RandomAccessIterator last,
+            Compare comp)
+{
+    if (first == last)
+        return last;
+    return first + HeapHelpers::minIndex(first, last - first, comp);
+}
+
+/*
+ * restore the heap condition after the priority of the changed element has
+ * been modified in either direction.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
 constexpr inline void
-downheap(RandomAccessIterator first, RandomAccessIterator last,
-         RandomAccessIterator changed, Compare comp)
+update_heap(RandomAccessIterator first, RandomAccessIterator last,
+            RandomAccessIterator changed, Compare comp, Policy policy = {})
 {
     using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
     using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::update);
     ValueType v = std::move(*changed);
 
-    HeapHelpers::downheap(first, DistanceType{},         // topIndex
-                          DistanceType{changed - first}, // k
-                          DistanceType(last - first),    // len
-                          std::move(v), comp);
+    HeapHelpers::adjust(first,
+                        DistanceType{changed - first}, // k
+                        DistanceType(last - first),    // len
+                        std::move(v), c, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
 }
 
 /**
- *  @brief  Push an element onto a heap using comparison functor.
+ *  @brief  Push an element onto a min-max heap using comparison functor.
  *  @param  first  Start of heap.
  *  @param  last   End of heap + element.
  *  @param  comp   Comparison functor.
+ *  @param  policy Heap policy.
  *  @ingroup heap_algorithms
  *
- *  This operation pushes the element at last-1 onto the valid
- *  heap over the range [first,last-1).  After completion,
- *  [first,last) is a valid heap.  Compare operations are
- *  performed using comp.
+ *  Min-max counterpart of Base::push_heap().
 */
-template<typename RandomAccessIterator, typename Compare>
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
 constexpr inline void
 push_heap(RandomAccessIterator first, RandomAccessIterator last,
-          Compare comp)
+          Compare comp, Policy policy = {})
 {
-    Base::upheap(first, last, last - 1, comp);
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::push);
+    ValueType v = std::move(*(last - 1));
+    const DistanceType k{(last - 1) - first};
+
+    // the new leaf has no descendant, it can only move up
+    HeapHelpers::adjust(first, k, k + 1, std::move(v), c, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
 }
 
 /**
- *  @brief  Pop an element off a heap using comparison functor.
+ *  @brief  Pop the highest priority element off a min-max heap.
  *  @param  first  Start of heap.
  *  @param  last   End of heap.
  *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
  *  @ingroup heap_algorithms
  *
- *  This operation pops the top of the heap.  The elements first
- *  and last-1 are swapped and [first,last-1) is made into a
- *  heap.  Comparisons are made using comp.
+ *  Moves *first to last - 1 and makes [first,last-1) into a min-max
+ *  heap. Min-max counterpart of Base::pop_heap().
  */
-template<typename RandomAccessIterator, typename Compare>
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
 constexpr inline void
-pop_heap(RandomAccessIterator first,
-         RandomAccessIterator last, Compare comp)
+pop_max(RandomAccessIterator first,
+        RandomAccessIterator last, Compare comp, Policy policy = {})
 {
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::pop);
     if (last - first > 1) {
         --last;
-        HeapHelpers::remove(first, last, first, last, comp);
+        HeapHelpers::remove(first, last, first, last, c, policy);
     }
+    else {
+        last = first;
+    }
+    HeapHelpers::endOp(first, last, comp, policy);
 }
 
-template<typename RandomAccessIterator, typename Compare>
+/**
+ *  @brief  Pop the lowest priority element off a min-max heap.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  Moves the lowest priority element to last - 1 and makes
+ *  [first,last-1) into a min-max heap.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr inline void
+pop_min(RandomAccessIterator first,
+        RandomAccessIterator last, Compare comp, Policy policy = {})
+{
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::pop);
+    if (last - first > 1) {
+        const auto popPos{first + HeapHelpers::minIndex(first, last - first, c)};
+
+        --last;
+        HeapHelpers::remove(first, last, popPos, last, c, policy);
+    }
+    else {
+        last = first;
+    }
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+/*
+ * remove the element at popPos and move it to last - 1.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
 constexpr inline void
 pop_heap(RandomAccessIterator first, RandomAccessIterator last,
          RandomAccessIterator popPos,
-         Compare comp)
+         Compare comp, Policy policy = {})
 {
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::erase);
     if (last - first > 1) {
         --last;
-        HeapHelpers::remove(first, last, popPos, last, comp);
+        HeapHelpers::remove(first, last, popPos, last, c, policy);
+    }
+    else {
+        last = first;
+    }
+    HeapHelpers::endOp(first, last, comp, policy);
+}
+
+/**
+ *  @brief  Construct a min-max heap over a range using comparison functor.
+ *  @param  first  Start of heap.
+ *  @param  last   End of heap.
+ *  @param  comp   Comparison functor to use.
+ *  @param  policy Heap policy.
+ *  @ingroup heap_algorithms
+ *
+ *  Floyd construction in O(n), alternating the kind of sift with the
+ *  level of every parent.
+ */
+template<typename RandomAccessIterator, typename Compare,
+         HeapPolicy Policy = default_policy>
+constexpr void
+make_heap(RandomAccessIterator first, RandomAccessIterator last,
+          Compare comp, Policy policy = {})
+{
+    using ValueType    = typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using DistanceType = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    const DistanceType len{last - first};
+    auto &&c{Base::HeapHelpers::instrument(comp, policy)};
+
+    policy.beginOp(heap_op::make);
+    for (DistanceType k{len / 2 - 1}; k >= 0; --k) {
+        ValueType v = std::move(*(first + k));
+
+        if (HeapHelpers::isMaxLevel(k))
+            HeapHelpers::downheap<true, false>(first, k, len, std::move(v),
+                                               c, policy);
+        else
+            HeapHelpers::downheap<false, false>(first, k, len, std::move(v),
+                                                c, policy);
     }
+    Base::HeapHelpers::setHeapIndexes(first, last, policy);
+    HeapHelpers::endOp(first, last, comp, policy);
+}
 }
 }
 
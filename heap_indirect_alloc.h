@@ -0,0 +1,239 @@
+#ifndef HEAP_INDIRECT_ALLOC_H_
+#define HEAP_INDIRECT_ALLOC_H_
+/*
+ * Indirect heap allocators
+ * https://github.com/lano1106/indirect_heap
+ *
+ * huge_page_allocator: allocator for the heap array. Large arrays are
+ * mapped in 2MB pages so that sifting a big heap does not miss the TLB at
+ * every level. Use it as the allocator of the container of
+ * Base::IndirectPriorityQueue:
+ *
+ * Base::IndirectPriorityQueue<Timer *, TimerCmp,
+ *     std::vector<Timer *, Base::huge_page_allocator<Timer *> > > q;
+ *
+ * The vector still grows geometrically. reserve() the expected size up
+ * front to avoid the copies of a growth.
+ *
+ * object_pool: slab allocator for the heap elements. Objects are carved
+ * out of slabs of contiguous fixed-size slots and recycled through a free
+ * list, so creating and destroying elements (ie: arming and cancelling
+ * timers) costs a few instructions and keeps them packed together.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace Base {
+
+namespace HeapHelpers {
+inline constexpr std::size_t HugePageSize = std::size_t{2} << 20;
+
+/*
+ * allocations of at least a huge page are mapped, rounded up to a
+ * multiple of the huge page size. Explicit huge pages are tried first.
+ * When none are reserved, a regular mapping is advised to be backed by
+ * transparent huge pages. It is only page aligned and they can only back
+ * its huge page aligned part: a huge page more is mapped and the slack
+ * around the aligned range is unmapped.
+ *
+ * Smaller ones come from operator new since wasting a mapping on them is
+ * not worth it. The size alone tells which way a block was allocated.
+ */
+inline void *allocatePages(std::size_t bytes, std::size_t align)
+{
+#if defined(__linux__)
+    if (bytes >= HugePageSize) {
+        const std::size_t len{(bytes + HugePageSize - 1) & ~(HugePageSize - 1)};
+        void *p{mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0)};
+
+        if (p == MAP_FAILED) {
+            p = mmap(nullptr, len + HugePageSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+                throw std::bad_alloc();
+
+            auto *const       raw{static_cast<char *>(p)};
+            const std::size_t head{(HugePageSize -
+                                    reinterpret_cast<std::uintptr_t>(raw) %
+                                        HugePageSize) % HugePageSize};
+
+            if (head)
+                munmap(raw, head);
+            munmap(raw + head + len, HugePageSize - head);
+            p = raw + head;
+            madvise(p, len, MADV_HUGEPAGE);
+        }
+        return p;
+    }
+#endif
+    return ::operator new(bytes, std::align_val_t{align});
+}
+
+inline void deallocatePages(void *p, std::size_t bytes,
+                            std::size_t align) noexcept
+{
+#if defined(__linux__)
+    if (bytes >= HugePageSize) {
+        munmap(p, (bytes + HugePageSize - 1) & ~(HugePageSize - 1));
+        return;
+    }
+#endif
+    ::operator delete(p, bytes, std::align_val_t{align});
+}
+}
+
+template <typename T>
+class huge_page_allocator
+{
+public:
+    using value_type = T;
+
+    huge_page_allocator() noexcept = default;
+    template <typename U>
+    huge_page_allocator(const huge_page_allocator<U> &) noexcept {}
+
+    [[nodiscard]] T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(HeapHelpers::allocatePages(n * sizeof(T),
+                                                           alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        HeapHelpers::deallocatePages(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    friend bool operator==(const huge_page_allocator &,
+                           const huge_page_allocator<U> &) noexcept
+    {
+        return true;
+    }
+};
+
+/*
+ * fixed-size object pool
+ *
+ * slabs of SlabSize objects are allocated with Allocator as needed and
+ * only released by the pool destructor. Destroyed objects are reused in
+ * LIFO order, while they are still hot in the caches.
+ *
+ * Every object must be destroyed before the pool.
+ */
+template <typename T, std::size_t SlabSize = 4096,
+          typename Allocator = std::allocator<T> >
+class object_pool
+{
+public:
+    static_assert(SlabSize > 0, "a slab must hold at least 1 object");
+
+    using value_type     = T;
+    using size_type      = std::size_t;
+    using allocator_type = Allocator;
+
+    object_pool() = default;
+    explicit object_pool(const Allocator &alloc) : m_alloc(alloc) {}
+
+    object_pool(const object_pool &) = delete;
+    object_pool &operator=(const object_pool &) = delete;
+
+    ~object_pool()
+    {
+        for (Slot *slab : m_slabs)
+            SlotTraits::deallocate(m_alloc, slab, SlabSize);
+    }
+
+    // objects alive
+    size_type size() const noexcept { return m_size; }
+    size_type capacity() const noexcept { return m_slabs.size() * SlabSize; }
+
+    // allocate slabs for at least n objects
+    void reserve(size_type n)
+    {
+        while (capacity() < n)
+            grow();
+    }
+
+    template <typename... Args>
+    [[nodiscard]] T *create(Args &&...args)
+    {
+        if (!m_free)
+            grow();
+
+        Slot *s{m_free};
+
+        m_free = s->next;
+        try {
+            T *p{::new (static_cast<void *>(s->storage))
+                     T(std::forward<Args>(args)...)};
+
+            ++m_size;
+            return p;
+        }
+        catch (...) {
+            s->next = m_free;
+            m_free  = s;
+            throw;
+        }
+    }
+
+    /*
+     * p must have been created by this pool.
+     */
+    void destroy(T *p) noexcept
+    {
+        p->~T();
+
+        Slot *s{reinterpret_cast<Slot *>(p)};
+
+        s->next = m_free;
+        m_free  = s;
+        --m_size;
+    }
+
+private:
+    union Slot
+    {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+    using SlotTraits    = std::allocator_traits<SlotAllocator>;
+
+    void grow()
+    {
+        // reserved before the allocation, push_back() cannot throw and
+        // leak the slab
+        if (m_slabs.size() == m_slabs.capacity())
+            m_slabs.reserve(std::max<size_type>(4, 2 * m_slabs.size()));
+
+        Slot *slab{SlotTraits::allocate(m_alloc, SlabSize)};
+
+        m_slabs.push_back(slab);
+        // the first free slot is at the lowest address
+        for (size_type i{SlabSize}; i-- > 0;) {
+            slab[i].next = m_free;
+            m_free       = &slab[i];
+        }
+    }
+
+    [[no_unique_address]] SlotAllocator m_alloc{};
+    std::vector<Slot *> m_slabs;
+    Slot               *m_free{};
+    size_type           m_size{};
+};
+}
+
+#endif
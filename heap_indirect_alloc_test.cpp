@@ -0,0 +1,91 @@
+/*
+ * indirect heap allocators test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g heap_indirect_alloc_test.cpp
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "heap_indirect_alloc.h"
+#include "priority_queue_indirect.h"
+
+struct Timer
+{
+    explicit Timer(char d) : deadline(d) {}
+
+    char   deadline;
+    size_t pos{};
+};
+
+/*
+ * provide functions required by Base::IndirectPriorityQueue
+ */
+inline void setHeapIndex(Timer *t, size_t idx)
+{
+    t->pos = idx;
+}
+
+inline size_t getHeapIndex(const Timer *t)
+{
+    return t->pos;
+}
+
+struct TimerCmp
+{
+    bool operator()(const Timer *lhs, const Timer *rhs) const
+    {
+        return lhs->deadline > rhs->deadline;
+    }
+};
+
+using TimerQueue = Base::IndirectPriorityQueue<Timer *, TimerCmp,
+                                               std::vector<Timer *, Base::huge_page_allocator<Timer *> > >;
+
+int main()
+{
+    Base::object_pool<Timer, 8, Base::huge_page_allocator<Timer> > pool;
+    TimerQueue q;
+    std::vector<Timer *> timers;
+    const char *str{"EASYQUESTION"};
+
+    // a heap array of at least a huge page
+    q.reserve(Base::HeapHelpers::HugePageSize / sizeof(Timer *));
+    for (const char *p{str}; *p; ++p) {
+        timers.push_back(pool.create(*p));
+        q.push(timers.back());
+    }
+    std::cout << "pool size: " << pool.size() << " capacity: " << pool.capacity() << '\n';
+    std::cout << "heap array huge page aligned: "
+              << (reinterpret_cast<std::uintptr_t>(q.container().data()) %
+                  Base::HeapHelpers::HugePageSize == 0) << '\n';
+
+    std::cout << "\ncancel(Y), cancel(U):\n";
+    q.erase(timers[3]);
+    pool.destroy(timers[3]);
+    q.erase(timers[5]);
+    pool.destroy(timers[5]);
+    for (const auto *t : q.container())
+        std::cout << t->deadline << ' ';
+    std::cout << '\n';
+
+    Timer *rearmed{pool.create('B')};
+
+    std::cout << "\nrearm(B), slot of U reused: " << (rearmed == timers[5])
+              << " pool size: " << pool.size() << '\n';
+    q.push(rearmed);
+
+    std::cout << "\npop all:\n";
+    while (!q.empty()) {
+        Timer *t{q.top()};
+
+        std::cout << t->deadline << ' ';
+        q.pop();
+        pool.destroy(t);
+    }
+    std::cout << "\npool size: " << pool.size() << '\n';
+
+    return 0;
+}
@@ -0,0 +1,577 @@
+/*
+ * heap indirect benchmark
+ * https://github.com/lano1106/indirect_heap
+ *
+ * compares the indirect heap algorithms, in binary, d-ary and B-heap
+ * layouts, against std::push_heap/pop_heap,
+ * std::multiset with iterator erase and, when available, the Boost
+ * pairing and d-ary heaps.
+ *
+ * Two workloads are run on heaps of 1K elements up to the max size:
+ *
+ * hold:  pop the top and push it back with a later key (timer queue)
+ * mixed: 50% hold, 25% erase + push of a random element,
+ *        25% key update of a random element
+ *
+ * The expiry workload measures pop_until() bursts: the timers expired
+ * by a clock jump, 1/64, 1/8 and 1/2 of the heap and 50K timers, are
+ * popped with individual pops only, with the default thresholds and
+ * with the bulk removal from the first pop. (see Base::bulk_pop_policy)
+ * It is the workload from which HeapHelpers::BulkPopMin and
+ * HeapHelpers::BulkPopHeapMin are measured.
+ *
+ * Each container is run twice on the same input: once to time it and once
+ * with counting comparator and element types to report the number of
+ * comparisons and moves (copies or moves of a heap slot) per operation.
+ * Containers that do not support erase or update are skipped for the mixed
+ * workload. Moves are not reported for node based containers.
+ *
+ * to compile:
+ * g++ -std=c++26 -O2 -DNDEBUG heap_indirect_bench.cpp
+ *
+ * usage:
+ * heap_indirect_bench [max size (default 10000000)] [ops (default 1048576)]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <type_traits>
+#include <vector>
+#include "heap_indirect.h"
+
+#if __has_include(<boost/heap/pairing_heap.hpp>) && __has_include(<boost/heap/d_ary_heap.hpp>)
+#define HAVE_BOOST_HEAP 1
+#include <boost/heap/d_ary_heap.hpp>
+#include <boost/heap/pairing_heap.hpp>
+#endif
+
+namespace {
+
+struct Counters
+{
+    uint64_t compares{};
+    uint64_t moves{};
+};
+
+Counters g_counters;
+
+struct Node
+{
+    uint64_t key;
+    size_t   pos;
+    uint32_t id;
+};
+
+/*
+ * heap slot. When Counting is true, every copy or move of a slot is
+ * counted.
+ */
+template <bool Counting>
+struct Handle
+{
+    Node *p;
+
+    Handle(Node *n) noexcept : p(n) {}
+    Node *operator->() const noexcept { return p; }
+    Handle(const Handle &rhs) noexcept : p(rhs.p) { count(); }
+    Handle &operator=(const Handle &rhs) noexcept
+    {
+        p = rhs.p;
+        count();
+        return *this;
+    }
+
+    static void count() noexcept
+    {
+        if constexpr (Counting)
+            ++g_counters.moves;
+    }
+};
+
+template <bool Counting>
+inline void setHeapIndex(Handle<Counting> &h, size_t idx)
+{
+    h.p->pos = idx;
+}
+
+/*
+ * min-heap order: a has a lower priority than b when its key is larger.
+ */
+template <bool Counting>
+struct HeapCmp
+{
+    bool operator()(const Node *a, const Node *b) const noexcept
+    {
+        if constexpr (Counting)
+            ++g_counters.compares;
+        return a->key > b->key;
+    }
+    template <bool C>
+    bool operator()(const Handle<C> &a, const Handle<C> &b) const noexcept
+    {
+        return (*this)(a.p, b.p);
+    }
+};
+
+template <bool Counting>
+struct SetCmp
+{
+    bool operator()(const Node *a, const Node *b) const noexcept
+    {
+        if constexpr (Counting)
+            ++g_counters.compares;
+        return a->key < b->key;
+    }
+};
+
+template <bool Counting>
+class StdHeap
+{
+public:
+    static constexpr const char *name{"std::push_heap/pop_heap"};
+    static constexpr bool supportsErase{false};
+    static constexpr bool countsMoves{true};
+
+    explicit StdHeap(std::vector<Node> &nodes)
+    {
+        m_c.reserve(nodes.size());
+        for (auto &n : nodes)
+            m_c.push_back(&n);
+        std::make_heap(m_c.begin(), m_c.end(), m_comp);
+    }
+
+    Node *top() const { return m_c.front().p; }
+
+    void hold(uint64_t key)
+    {
+        std::pop_heap(m_c.begin(), m_c.end(), m_comp);
+        m_c.back().p->key = key;
+        std::push_heap(m_c.begin(), m_c.end(), m_comp);
+    }
+
+    void reschedule(Node *, uint64_t) {}
+    void update(Node *, uint64_t) {}
+
+private:
+    std::vector<Handle<Counting> > m_c;
+    HeapCmp<Counting>              m_comp;
+};
+
+template <std::size_t Arity, typename Policy, bool Counting>
+class IndirectHeap
+{
+public:
+    static constexpr const char *name{
+        Arity == 2 ? (std::is_same_v<Policy, Base::bottom_up_policy> ?
+                          "Base heap (bottom-up)" :
+                      std::is_same_v<Policy, Base::prefetch_policy<> > ?
+                          "Base heap (prefetch)" : "Base heap") :
+        Arity == 4 ? "Base::dary<4> heap" : "Base::dary<8> heap"};
+    static constexpr bool supportsErase{true};
+    static constexpr bool countsMoves{true};
+
+    explicit IndirectHeap(std::vector<Node> &nodes)
+    {
+        m_c.reserve(nodes.size());
+        for (auto &n : nodes)
+            m_c.push_back(&n);
+        if constexpr (Arity == 2)
+            Base::make_heap(m_c.begin(), m_c.end(), m_comp);
+        else
+            Base::dary::make_heap<Arity>(m_c.begin(), m_c.end(), m_comp);
+    }
+
+    Node *top() const { return m_c.front().p; }
+
+    void hold(uint64_t key)
+    {
+        popAt(0);
+        Node *n{m_c.back().p};
+        n->key = key;
+        pushBack();
+    }
+
+    void reschedule(Node *n, uint64_t key)
+    {
+        popAt(n->pos);
+        m_c.pop_back();
+        n->key = key;
+        m_c.push_back(n);
+        pushBack();
+    }
+
+    void update(Node *n, uint64_t key)
+    {
+        n->key = key;
+        if constexpr (Arity == 2)
+            Base::update_heap(m_c.begin(), m_c.end(), m_c.begin() + n->pos,
+                              m_comp, Policy{});
+        else
+            Base::dary::update_heap<Arity>(m_c.begin(), m_c.end(),
+                                           m_c.begin() + n->pos, m_comp,
+                                           Policy{});
+    }
+
+private:
+    void popAt(size_t pos)
+    {
+        if constexpr (Arity == 2)
+            Base::pop_heap(m_c.begin(), m_c.end(), m_c.begin() + pos, m_comp,
+                           Policy{});
+        else
+            Base::dary::pop_heap<Arity>(m_c.begin(), m_c.end(),
+                                        m_c.begin() + pos, m_comp, Policy{});
+    }
+
+    void pushBack()
+    {
+        if constexpr (Arity == 2)
+            Base::push_heap(m_c.begin(), m_c.end(), m_comp, Policy{});
+        else
+            Base::dary::push_heap<Arity>(m_c.begin(), m_c.end(), m_comp,
+                                         Policy{});
+    }
+
+    std::vector<Handle<Counting> > m_c;
+    HeapCmp<Counting>              m_comp;
+};
+
+template <std::size_t Levels, bool Counting>
+class BlockedHeap
+{
+public:
+    static constexpr const char *name{
+        Levels == 3 ? "Base::bheap<3> heap" : "Base::bheap<9> heap"};
+    static constexpr bool supportsErase{true};
+    static constexpr bool countsMoves{true};
+
+    explicit BlockedHeap(std::vector<Node> &nodes)
+    {
+        m_c.reserve(nodes.size());
+        for (auto &n : nodes)
+            m_c.push_back(&n);
+        Base::bheap::make_heap<Levels>(m_c.begin(), m_c.end(), m_comp);
+    }
+
+    Node *top() const { return m_c.front().p; }
+
+    void hold(uint64_t key)
+    {
+        Base::bheap::pop_heap<Levels>(m_c.begin(), m_c.end(), m_comp);
+        m_c.back().p->key = key;
+        Base::bheap::push_heap<Levels>(m_c.begin(), m_c.end(), m_comp);
+    }
+
+    void reschedule(Node *n, uint64_t key)
+    {
+        Base::bheap::pop_heap<Levels>(m_c.begin(), m_c.end(),
+                                      m_c.begin() + n->pos, m_comp);
+        m_c.pop_back();
+        n->key = key;
+        m_c.push_back(n);
+        Base::bheap::push_heap<Levels>(m_c.begin(), m_c.end(), m_comp);
+    }
+
+    void update(Node *n, uint64_t key)
+    {
+        n->key = key;
+        Base::bheap::update_heap<Levels>(m_c.begin(), m_c.end(),
+                                         m_c.begin() + n->pos, m_comp);
+    }
+
+private:
+    std::vector<Handle<Counting> > m_c;
+    HeapCmp<Counting>              m_comp;
+};
+
+template <bool Counting>
+class StdSet
+{
+public:
+    using set_type = std::multiset<Node *, SetCmp<Counting> >;
+
+    static constexpr const char *name{"std::multiset"};
+    static constexpr bool supportsErase{true};
+    static constexpr bool countsMoves{false};
+
+    explicit StdSet(std::vector<Node> &nodes)
+    : m_its(nodes.size())
+    {
+        for (auto &n : nodes)
+            m_its[n.id] = m_s.insert(&n);
+    }
+
+    Node *top() const { return *m_s.begin(); }
+
+    void hold(uint64_t key) { reschedule(top(), key); }
+
+    void reschedule(Node *n, uint64_t key)
+    {
+        m_s.erase(m_its[n->id]);
+        n->key = key;
+        m_its[n->id] = m_s.insert(n);
+    }
+
+    void update(Node *n, uint64_t key) { reschedule(n, key); }
+
+private:
+    set_type                                m_s;
+    std::vector<typename set_type::iterator> m_its;
+};
+
+#ifdef HAVE_BOOST_HEAP
+template <typename BoostHeap>
+class BoostHeapAdaptor
+{
+public:
+    static constexpr bool supportsErase{true};
+    static constexpr bool countsMoves{false};
+
+    explicit BoostHeapAdaptor(std::vector<Node> &nodes)
+    : m_handles(nodes.size())
+    {
+        for (auto &n : nodes)
+            m_handles[n.id] = m_h.push(&n);
+    }
+
+    Node *top() const { return m_h.top(); }
+
+    void hold(uint64_t key)
+    {
+        Node *n{m_h.top()};
+
+        m_h.pop();
+        n->key = key;
+        m_handles[n->id] = m_h.push(n);
+    }
+
+    void reschedule(Node *n, uint64_t key)
+    {
+        m_h.erase(m_handles[n->id]);
+        n->key = key;
+        m_handles[n->id] = m_h.push(n);
+    }
+
+    void update(Node *n, uint64_t key)
+    {
+        n->key = key;
+        m_h.update(m_handles[n->id]);
+    }
+
+private:
+    BoostHeap                                    m_h;
+    std::vector<typename BoostHeap::handle_type> m_handles;
+};
+
+template <bool Counting>
+struct BoostPairing
+: BoostHeapAdaptor<boost::heap::pairing_heap<
+      Node *, boost::heap::compare<HeapCmp<Counting> > > >
+{
+    static constexpr const char *name{"boost::heap::pairing_heap"};
+    using BoostHeapAdaptor<boost::heap::pairing_heap<
+        Node *, boost::heap::compare<HeapCmp<Counting> > > >::BoostHeapAdaptor;
+};
+
+template <bool Counting>
+struct BoostDary
+: BoostHeapAdaptor<boost::heap::d_ary_heap<
+      Node *, boost::heap::arity<4>, boost::heap::mutable_<true>,
+      boost::heap::compare<HeapCmp<Counting> > > >
+{
+    static constexpr const char *name{"boost::heap::d_ary_heap<4>"};
+    using BoostHeapAdaptor<boost::heap::d_ary_heap<
+        Node *, boost::heap::arity<4>, boost::heap::mutable_<true>,
+        boost::heap::compare<HeapCmp<Counting> > > >::BoostHeapAdaptor;
+};
+#endif
+
+enum class Workload { Hold, Mixed };
+
+constexpr uint64_t KeyRange{1ULL << 32};
+constexpr uint64_t DeltaRange{1ULL << 20};
+
+/*
+ * returns the elapsed time in ns.
+ */
+template <typename Heap>
+double runOnce(Workload w, std::size_t n, const std::vector<uint64_t> &rnd)
+{
+    std::vector<Node> nodes(n);
+    std::mt19937_64   gen{n};
+
+    for (std::size_t i{}; i < n; ++i)
+        nodes[i] = {gen() % KeyRange, 0, static_cast<uint32_t>(i)};
+
+    Heap heap(nodes);
+    g_counters = {};
+
+    const auto start{std::chrono::steady_clock::now()};
+
+    for (const auto r : rnd) {
+        const uint64_t key{heap.top()->key + (r >> 40) % DeltaRange};
+
+        if (w == Workload::Hold || (r & 3) < 2) {
+            heap.hold(key);
+        }
+        else {
+            Node *target{&nodes[(r >> 2) % n]};
+
+            if ((r & 3) == 2)
+                heap.reschedule(target, key);
+            else
+                heap.update(target, key);
+        }
+    }
+
+    const auto end{std::chrono::steady_clock::now()};
+
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+template <template <bool> class Heap>
+void run(Workload w, std::size_t n, const std::vector<uint64_t> &rnd)
+{
+    if (w == Workload::Mixed && !Heap<false>::supportsErase)
+        return;
+
+    const double ns{runOnce<Heap<false> >(w, n, rnd)};
+    runOnce<Heap<true> >(w, n, rnd);
+
+    const double ops{static_cast<double>(rnd.size())};
+    char         moves[32]{"-"};
+
+    if (Heap<true>::countsMoves)
+        std::snprintf(moves, sizeof(moves), "%.2f", g_counters.moves / ops);
+    std::printf("%-6s %9zu  %-28s %10.1f %10.2f %10s\n",
+                w == Workload::Hold ? "hold" : "mixed", n, Heap<false>::name,
+                ns / ops, g_counters.compares / ops, moves);
+}
+
+/*
+ * pop_until() of the burst lowest keys of a heap of n timers. Returns the
+ * elapsed time in ns per popped timer, over enough bursts to pop about
+ * ops timers.
+ */
+template <typename Policy, bool Counting>
+double runExpiryOnce(std::size_t n, std::size_t burst, std::size_t ops)
+{
+    std::vector<Node> nodes(n);
+    std::mt19937_64   gen{n};
+
+    for (std::size_t i{}; i < n; ++i)
+        nodes[i] = {gen() % KeyRange, 0, static_cast<uint32_t>(i)};
+
+    std::vector<uint64_t> keys(n);
+
+    for (std::size_t i{}; i < n; ++i)
+        keys[i] = nodes[i].key;
+    std::nth_element(keys.begin(), keys.begin() + (burst - 1), keys.end());
+
+    const uint64_t now{keys[burst - 1]};
+    const auto     expired{[now](const Handle<Counting> &h){ return h->key <= now; }};
+    std::vector<Handle<Counting> > heap;
+    std::vector<Handle<Counting> > out;
+    HeapCmp<Counting>              comp;
+
+    heap.reserve(n);
+    for (auto &node : nodes)
+        heap.push_back(&node);
+    Base::make_heap(heap.begin(), heap.end(), comp);
+
+    const std::vector<Handle<Counting> > orig(heap);
+    const std::size_t                    bursts{std::max<std::size_t>(ops / burst, 1)};
+    double                               ns{};
+
+    out.reserve(burst);
+    g_counters = {};
+    for (std::size_t i{}; i < bursts; ++i) {
+        heap = orig;
+        out.clear();
+
+        const auto start{std::chrono::steady_clock::now()};
+
+        Base::pop_until(heap.begin(), heap.end(), expired,
+                        std::back_inserter(out), comp, Policy{});
+
+        const auto end{std::chrono::steady_clock::now()};
+
+        ns += std::chrono::duration<double, std::nano>(end - start).count();
+    }
+    return ns / static_cast<double>(bursts * burst);
+}
+
+template <typename Policy>
+void runExpiry(const char *name, std::size_t n, std::size_t burst,
+               std::size_t ops)
+{
+    const double ns{runExpiryOnce<Policy, false>(n, burst, ops)};
+    runExpiryOnce<Policy, true>(n, burst, ops);
+
+    const double popped{static_cast<double>(std::max<std::size_t>(ops / burst, 1) * burst)};
+
+    std::printf("%-6s %9zu  %-28s %10.1f %10.2f %10zu\n", "expiry", n, name,
+                ns, g_counters.compares / popped, burst);
+}
+
+template <bool C> using BaseHeap         = IndirectHeap<2, Base::default_policy, C>;
+template <bool C> using BaseBottomUpHeap = IndirectHeap<2, Base::bottom_up_policy, C>;
+template <bool C> using BasePrefetchHeap = IndirectHeap<2, Base::prefetch_policy<>, C>;
+template <bool C> using Base4Heap        = IndirectHeap<4, Base::default_policy, C>;
+template <bool C> using Base8Heap        = IndirectHeap<8, Base::default_policy, C>;
+template <bool C> using BaseBHeap3       = BlockedHeap<3, C>;
+template <bool C> using BaseBHeap9       = BlockedHeap<9, C>;
+
+using IndividualPops = Base::bulk_pop_policy<SIZE_MAX, SIZE_MAX>;
+using BulkPops       = Base::bulk_pop_policy<0, 0>;
+}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t maxSize{argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000};
+    const std::size_t numOps{argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1U << 20};
+    std::vector<uint64_t> rnd(numOps);
+    std::mt19937_64       gen{42};
+
+    for (auto &r : rnd)
+        r = gen();
+
+    std::printf("%-6s %9s  %-28s %10s %10s %10s\n",
+                "load", "size", "container", "ns/op", "cmp/op", "moves/op");
+    for (const auto w : {Workload::Hold, Workload::Mixed}) {
+        for (std::size_t n{1000}; n <= maxSize; n *= 10) {
+            run<StdHeap>(w, n, rnd);
+            run<BaseHeap>(w, n, rnd);
+            run<BaseBottomUpHeap>(w, n, rnd);
+            run<BasePrefetchHeap>(w, n, rnd);
+            run<Base4Heap>(w, n, rnd);
+            run<Base8Heap>(w, n, rnd);
+            run<BaseBHeap3>(w, n, rnd);
+            run<BaseBHeap9>(w, n, rnd);
+            run<StdSet>(w, n, rnd);
+#ifdef HAVE_BOOST_HEAP
+            run<BoostPairing>(w, n, rnd);
+            run<BoostDary>(w, n, rnd);
+#endif
+        }
+    }
+
+    std::printf("\n%-6s %9s  %-28s %10s %10s %10s\n",
+                "load", "size", "pop_until", "ns/pop", "cmp/pop", "burst");
+    for (std::size_t n{1000}; n <= maxSize; n *= 10) {
+        for (const std::size_t burst : {n / 64, n / 8, n / 2, std::size_t{50000}}) {
+            if (burst == 0 || burst > n || (burst == 50000 && n / 2 == burst))
+                continue;
+            runExpiry<IndividualPops>("individual pops", n, burst, numOps);
+            runExpiry<Base::default_policy>("default thresholds", n, burst, numOps);
+            runExpiry<BulkPops>("bulk from the first pop", n, burst, numOps);
+        }
+    }
+
+    return 0;
+}
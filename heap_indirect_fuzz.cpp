@@ -0,0 +1,437 @@
+/*
+ * indirect heap fuzz target
+ * https://github.com/lano1106/indirect_heap
+ *
+ * runs the operations encoded by the input on Base::IndirectPriorityQueue,
+ * with both sift strategies and with the bulk removal of pop_until() from
+ * the first pop, and on a reference model. Base::verify_policy checks the
+ * heap and the recorded positions after every operation and the results
+ * are compared with the model.
+ *
+ * The same input is run on the 4-ary, B-heap and min-max algorithms with
+ * Base::verify_policy, which checks their own layout. The harness checks
+ * the heap condition and the recorded positions independently after
+ * every operation.
+ *
+ * libFuzzer build:
+ * clang++ -std=c++26 -g -O1 -DHEAP_INDIRECT_LIBFUZZER -fsanitize=fuzzer,address heap_indirect_fuzz.cpp
+ *
+ * standalone build, running random inputs:
+ * g++ -std=c++26 -g -O1 heap_indirect_fuzz.cpp
+ *
+ * usage:
+ * heap_indirect_fuzz [inputs (default 100000)] [seed (default 1)]
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+#include "priority_queue_indirect.h"
+
+namespace {
+
+constexpr std::size_t NumElems{64};
+
+struct Elem
+{
+    std::uint8_t key;
+    std::uint8_t id;
+    bool         queued;
+    std::size_t  pos;
+};
+
+inline void setHeapIndex(Elem *e, std::size_t idx)
+{
+    e->pos = idx;
+}
+
+inline std::size_t getHeapIndex(const Elem *e)
+{
+    return e->pos;
+}
+
+struct ElemCmp
+{
+    bool operator()(const Elem *lhs, const Elem *rhs) const noexcept
+    {
+        return lhs->key < rhs->key;
+    }
+};
+
+void check(bool cond, const char *what)
+{
+    if (!cond) {
+        std::fprintf(stderr, "model mismatch: %s\n", what);
+        std::abort();
+    }
+}
+
+/*
+ * queue under test and its model, the (key, id) pairs of the queued
+ * elements
+ */
+template <typename Policy>
+class Harness
+{
+public:
+    using Queue = Base::IndirectPriorityQueue<Elem *, ElemCmp,
+                                              std::vector<Elem *>,
+                                              Base::verify_policy<Policy> >;
+
+    Harness()
+    {
+        for (std::size_t i{}; i < NumElems; ++i)
+            m_elems[i] = {0, static_cast<std::uint8_t>(i), false, 0};
+    }
+
+    void run(const std::uint8_t *data, std::size_t size)
+    {
+        for (; size >= 3; data += 3, size -= 3)
+            apply(data[0] % 8, m_elems[data[1] % NumElems], data[2]);
+        checkTop();
+    }
+
+private:
+    void apply(unsigned op, Elem &e, std::uint8_t arg)
+    {
+        switch (op) {
+        case 0: // push
+            if (!e.queued) {
+                e.key = arg;
+                insert(e);
+                m_q.push(&e);
+            }
+            break;
+        case 1: // pop
+            if (!m_q.empty()) {
+                checkTop();
+                Elem *top{m_q.top()};
+
+                m_q.pop();
+                remove(*top);
+            }
+            break;
+        case 2: // erase
+            if (e.queued) {
+                m_q.erase(&e);
+                remove(e);
+            }
+            break;
+        case 3: // update
+            if (e.queued) {
+                remove(e);
+                e.key = arg;
+                insert(e);
+                m_q.update(&e);
+            }
+            break;
+        case 4: // replace_top
+            if (!e.queued && !m_q.empty()) {
+                checkTop();
+                remove(*m_q.top());
+                e.key = arg;
+                insert(e);
+                m_q.replace_top(&e);
+            }
+            break;
+        case 5: // push_pop
+            if (!e.queued) {
+                checkTop();
+                e.key = arg;
+                insert(e);
+
+                Elem *popped{m_q.push_pop(&e)};
+
+                check(popped->key == m_model.rbegin()->first, "push_pop key");
+                remove(*popped);
+            }
+            break;
+        case 6: // pop_until
+        {
+            std::vector<Elem *> out;
+            const auto n{m_q.pop_until([arg](const Elem *x){ return x->key >= arg; },
+                                       std::back_inserter(out))};
+
+            check(n == out.size(), "pop_until count");
+            for (Elem *x : out) {
+                check(x->key >= arg && x->key == m_model.rbegin()->first,
+                      "pop_until order");
+                remove(*x);
+            }
+            check(m_q.empty() || m_q.top()->key < arg, "pop_until stop");
+            break;
+        }
+        case 7: // pop_n
+        {
+            std::vector<Elem *> out;
+
+            m_q.pop_n(arg % 8, std::back_inserter(out));
+            for (Elem *x : out) {
+                check(x->key == m_model.rbegin()->first, "pop_n order");
+                remove(*x);
+            }
+            break;
+        }
+        }
+        check(m_q.size() == m_model.size(), "size");
+    }
+
+    void insert(Elem &e)
+    {
+        e.queued = true;
+        m_model.emplace(e.key, e.id);
+    }
+
+    void remove(Elem &e)
+    {
+        check(e.queued && m_model.erase({e.key, e.id}) == 1, "removed element");
+        e.queued = false;
+    }
+
+    void checkTop()
+    {
+        check(m_q.empty() == m_model.empty(), "empty");
+        if (!m_q.empty())
+            check(m_q.top()->key == m_model.rbegin()->first, "top key");
+    }
+
+    Elem m_elems[NumElems];
+    Queue m_q;
+    std::set<std::pair<std::uint8_t, std::uint8_t> > m_model;
+};
+
+/*
+ * other heap layouts: the parent of a slot for the heap condition check
+ * and the algorithms run by LayoutHarness
+ */
+using Verify = Base::verify_policy<>;
+
+struct DaryLayout
+{
+    static constexpr bool minMax = false;
+
+    static std::size_t parent(std::size_t k) { return (k - 1) / 4; }
+
+    template <typename It> static void push(It f, It l) { Base::dary::push_heap<4>(f, l, ElemCmp{}, Verify{}); }
+    template <typename It> static void pop(It f, It l) { Base::dary::pop_heap<4>(f, l, ElemCmp{}, Verify{}); }
+    template <typename It> static void erase(It f, It l, It p) { Base::dary::pop_heap<4>(f, l, p, ElemCmp{}, Verify{}); }
+    template <typename It> static void update(It f, It l, It p) { Base::dary::update_heap<4>(f, l, p, ElemCmp{}, Verify{}); }
+    template <typename It> static void make(It f, It l) { Base::dary::make_heap<4>(f, l, ElemCmp{}, Verify{}); }
+    template <typename It> static Elem *replaceTop(It f, It l, Elem *v)
+    {
+        return Base::dary::replace_top<4>(f, l, v, ElemCmp{}, Verify{});
+    }
+};
+
+struct BlockedLayout
+{
+    static constexpr bool minMax = false;
+
+    static std::size_t parent(std::size_t k)
+    {
+        return Base::bheap::HeapHelpers::layout<3>::parent(k);
+    }
+
+    template <typename It> static void push(It f, It l) { Base::bheap::push_heap<3>(f, l, ElemCmp{}, Verify{}); }
+    template <typename It> static void pop(It f, It l) { Base::bheap::pop_heap<3>(f, l, ElemCmp{}, Verify{}); }
+    template <typename It> static void erase(It f, It l, It p) { Base::bheap::pop_heap<3>(f, l, p, ElemCmp{}, Verify{}); }
+    template <typename It> static void update(It f, It l, It p) { Base::bheap::update_heap<3>(f, l, p, ElemCmp{}, Verify{}); }
+    template <typename It> static void make(It f, It l) { Base::bheap::make_heap<3>(f, l, ElemCmp{}, Verify{}); }
+    template <typename It> static Elem *replaceTop(It f, It l, Elem *v)
+    {
+        return Base::bheap::replace_top<3>(f, l, v, ElemCmp{}, Verify{});
+    }
+};
+
+struct MinMaxLayout
+{
+    static constexpr bool minMax = true;
+
+    static std::size_t parent(std::size_t k) { return (k - 1) / 2; }
+
+    template <typename It> static void push(It f, It l) { Base::minmax::push_heap(f, l, ElemCmp{}, Verify{}); }
+    template <typename It> static void pop(It f, It l) { Base::minmax::pop_max(f, l, ElemCmp{}, Verify{}); }
+    template <typename It> static void popMin(It f, It l) { Base::minmax::pop_min(f, l, ElemCmp{}, Verify{}); }
+    template <typename It> static void erase(It f, It l, It p) { Base::minmax::pop_heap(f, l, p, ElemCmp{}, Verify{}); }
+    template <typename It> static void update(It f, It l, It p) { Base::minmax::update_heap(f, l, p, ElemCmp{}, Verify{}); }
+    template <typename It> static void make(It f, It l) { Base::minmax::make_heap(f, l, ElemCmp{}, Verify{}); }
+};
+
+/*
+ * runs the input on a heap array laid out by Layout and on its model
+ */
+template <typename Layout>
+class LayoutHarness
+{
+public:
+    LayoutHarness()
+    {
+        for (std::size_t i{}; i < NumElems; ++i)
+            m_elems[i] = {0, static_cast<std::uint8_t>(i), false, 0};
+    }
+
+    void run(const std::uint8_t *data, std::size_t size)
+    {
+        for (; size >= 3; data += 3, size -= 3) {
+            apply(data[0] % 6, m_elems[data[1] % NumElems], data[2]);
+            checkHeap();
+        }
+    }
+
+private:
+    void apply(unsigned op, Elem &e, std::uint8_t arg)
+    {
+        switch (op) {
+        case 0: // push
+            if (!e.queued) {
+                e.key = arg;
+                insert(e);
+                m_heap.push_back(&e);
+                Layout::push(m_heap.begin(), m_heap.end());
+            }
+            break;
+        case 1: // pop
+            if (!m_heap.empty()) {
+                Layout::pop(m_heap.begin(), m_heap.end());
+                check(m_heap.back()->key == m_model.rbegin()->first, "pop key");
+                remove(*m_heap.back());
+                m_heap.pop_back();
+            }
+            break;
+        case 2: // erase
+            if (e.queued) {
+                Layout::erase(m_heap.begin(), m_heap.end(), m_heap.begin() + e.pos);
+                check(m_heap.back() == &e, "erased element");
+                remove(e);
+                m_heap.pop_back();
+            }
+            break;
+        case 3: // update
+            if (e.queued) {
+                remove(e);
+                e.key = arg;
+                insert(e);
+                Layout::update(m_heap.begin(), m_heap.end(), m_heap.begin() + e.pos);
+            }
+            break;
+        case 4: // replace_top or pop_min
+            if constexpr (Layout::minMax) {
+                if (!m_heap.empty()) {
+                    Layout::popMin(m_heap.begin(), m_heap.end());
+                    check(m_heap.back()->key == m_model.begin()->first, "pop_min key");
+                    remove(*m_heap.back());
+                    m_heap.pop_back();
+                }
+            }
+            else if (!e.queued && !m_heap.empty()) {
+                const std::uint8_t topKey{m_model.rbegin()->first};
+
+                e.key = arg;
+                insert(e);
+
+                Elem *top{Layout::replaceTop(m_heap.begin(), m_heap.end(), &e)};
+
+                check(top->key == topKey, "replace_top key");
+                remove(*top);
+            }
+            break;
+        case 5: // make_heap
+            Layout::make(m_heap.begin(), m_heap.end());
+            break;
+        }
+        check(m_heap.size() == m_model.size(), "size");
+    }
+
+    /*
+     * recorded positions and heap condition against the parent, and the
+     * grandparent for a min-max heap, whose levels alternate
+     */
+    void checkHeap()
+    {
+        for (std::size_t k{}; k < m_heap.size(); ++k) {
+            const Elem *x{m_heap[k]};
+
+            check(x->pos == k, "recorded position");
+            if (k == 0)
+                continue;
+
+            const std::size_t p{Layout::parent(k)};
+
+            if constexpr (Layout::minMax) {
+                const bool maxLevel{(std::bit_width(p + 1) & 1) == 1};
+
+                check(maxLevel ? x->key <= m_heap[p]->key : x->key >= m_heap[p]->key,
+                      "min-max parent");
+                if (p > 0)
+                    check(maxLevel ? x->key >= m_heap[(p - 1) / 2]->key
+                                   : x->key <= m_heap[(p - 1) / 2]->key,
+                          "min-max grandparent");
+            }
+            else {
+                check(x->key <= m_heap[p]->key, "heap condition");
+            }
+        }
+        if (!m_heap.empty())
+            check(m_heap.front()->key == m_model.rbegin()->first, "top key");
+    }
+
+    void insert(Elem &e)
+    {
+        e.queued = true;
+        m_model.emplace(e.key, e.id);
+    }
+
+    void remove(Elem &e)
+    {
+        check(e.queued && m_model.erase({e.key, e.id}) == 1, "removed element");
+        e.queued = false;
+    }
+
+    Elem m_elems[NumElems];
+    std::vector<Elem *> m_heap;
+    std::set<std::pair<std::uint8_t, std::uint8_t> > m_model;
+};
+
+void fuzzOne(const std::uint8_t *data, std::size_t size)
+{
+    Harness<Base::top_down_policy>().run(data, size);
+    Harness<Base::bottom_up_policy>().run(data, size);
+    Harness<Base::bulk_pop_policy<0, 0> >().run(data, size);
+    LayoutHarness<DaryLayout>().run(data, size);
+    LayoutHarness<BlockedLayout>().run(data, size);
+    LayoutHarness<MinMaxLayout>().run(data, size);
+}
+}
+
+#ifdef HEAP_INDIRECT_LIBFUZZER
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size)
+{
+    fuzzOne(data, size);
+    return 0;
+}
+#else
+int main(int argc, char *argv[])
+{
+    const std::size_t inputs{argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000};
+    std::mt19937      gen{argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 1U};
+    std::vector<std::uint8_t> input;
+
+    for (std::size_t i{}; i < inputs; ++i) {
+        input.resize(gen() % 1536);
+        for (auto &b : input)
+            b = static_cast<std::uint8_t>(gen());
+        fuzzOne(input.data(), input.size());
+    }
+    std::printf("%zu inputs passed\n", inputs);
+
+    return 0;
+}
+#endif
@@ -0,0 +1,349 @@
+#ifndef HEAP_INDIRECT_RANGES_H_
+#define HEAP_INDIRECT_RANGES_H_
+/*
+ * Indirect heap algorithms ranges interface
+ * https://github.com/lano1106/indirect_heap
+ *
+ * Base::ranges mirrors the std::ranges heap algorithms: they take a range
+ * or an iterator and a sentinel, compare with std::ranges::less by default
+ * and apply a projection to the elements before comparing them, so that
+ * keys are extracted without a custom comparator:
+ *
+ * Base::ranges::push_heap(timers, std::ranges::greater{}, &Timer::deadline);
+ *
+ * The positions are recorded by setHeapIndex(), found by ADL, or by the
+ * policy. Base::projected_index_policy records them through a projection
+ * instead, ie: to a member of the elements:
+ *
+ * Base::ranges::push_heap(tasks, std::ranges::greater{}, &Task::deadline,
+ *                         Base::projected_index_policy{&Task::pos});
+ *
+ * Base::set_heap_index and Base::get_heap_index are the customization
+ * point objects accessing a position, with or without a projection.
+ *
+ * The algorithms are constexpr: a static heap can be built and verified at
+ * compile time. (see heap_indirect_ranges_test.cpp)
+ */
+
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include "heap_indirect.h"
+
+namespace Base {
+
+namespace HeapHelpers {
+/*
+ * compares the projections of the elements
+ */
+template <typename Compare, typename Proj>
+struct projected_compare
+{
+    [[no_unique_address]] Compare comp;
+    [[no_unique_address]] Proj    proj;
+
+    template <typename Lhs, typename Rhs>
+    constexpr bool operator()(const Lhs &lhs, const Rhs &rhs)
+    {
+        return std::invoke(comp, std::invoke(proj, lhs), std::invoke(proj, rhs));
+    }
+};
+
+struct set_heap_index_fn
+{
+    template <typename T, typename Distance>
+    requires requires (T &e, Distance k) { setHeapIndex(e, k); }
+    constexpr void operator()(T &e, Distance k) const
+    {
+        setHeapIndex(e, k);
+    }
+
+    template <typename T, typename Distance, typename Proj>
+    requires std::is_lvalue_reference_v<std::invoke_result_t<Proj &, T &> >
+    constexpr void operator()(T &e, Distance k, Proj proj) const
+    {
+        using IndexType = std::remove_cvref_t<std::invoke_result_t<Proj &, T &> >;
+
+        std::invoke(proj, e) = static_cast<IndexType>(k);
+    }
+};
+
+struct get_heap_index_fn
+{
+    template <typename T>
+    requires requires (const T &e) { getHeapIndex(e); }
+    constexpr auto operator()(const T &e) const
+    {
+        return getHeapIndex(e);
+    }
+
+    template <typename T, typename Proj>
+    constexpr auto operator()(const T &e, Proj proj) const
+    {
+        return std::remove_cvref_t<std::invoke_result_t<Proj &, const T &> >{
+            std::invoke(proj, e)};
+    }
+};
+}
+
+/*
+ * set_heap_index(e, k):       setHeapIndex(e, k) found by ADL.
+ * set_heap_index(e, k, proj): assigns k to std::invoke(proj, e), ie: a
+ *                             pointer to the index member of e or *e.
+ */
+inline constexpr HeapHelpers::set_heap_index_fn set_heap_index{};
+
+/*
+ * get_heap_index(e):          getHeapIndex(e) found by ADL.
+ * get_heap_index(e, proj):    std::invoke(proj, e).
+ */
+inline constexpr HeapHelpers::get_heap_index_fn get_heap_index{};
+
+/*
+ * projected index heap policy
+ *
+ * records the positions in std::invoke(proj, element) instead of calling
+ * setHeapIndex(), ie: Base::projected_index_policy{&Task::pos}. Usable
+ * with the iterator algorithms as well.
+ *
+ * Policy is the policy extended with the projection.
+ */
+template <typename Proj, typename Policy = default_policy>
+struct projected_index_policy : Policy
+{
+    [[no_unique_address]] Proj proj;
+
+    explicit constexpr projected_index_policy(Proj p,
+                                              const Policy &policy = Policy())
+    : Policy(policy), proj(std::move(p)) {}
+
+    template <typename T, typename Distance>
+    constexpr void recordHeapIndex(T &e, Distance k)
+    {
+        Base::set_heap_index(e, k, proj);
+    }
+
+    template <typename T>
+    constexpr auto heapIndex(const T &e) const
+    {
+        return Base::get_heap_index(e, proj);
+    }
+};
+
+namespace ranges {
+
+/*
+ * push the element at last - 1 onto the heap [first,last - 1).
+ * Returns last. (see Base::push_heap())
+ */
+template <std::random_access_iterator I, std::sentinel_for<I> S,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<I, Compare, Proj>
+constexpr I
+push_heap(I first, S last, Compare comp = {}, Proj proj = {},
+          Policy policy = {})
+{
+    const I end{std::ranges::next(first, last)};
+
+    Base::push_heap(first, end,
+                    HeapHelpers::projected_compare<Compare, Proj>{
+                        std::move(comp), std::move(proj)},
+                    std::move(policy));
+    return end;
+}
+
+template <std::ranges::random_access_range R,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<std::ranges::iterator_t<R>, Compare, Proj>
+constexpr std::ranges::borrowed_iterator_t<R>
+push_heap(R &&r, Compare comp = {}, Proj proj = {}, Policy policy = {})
+{
+    return ranges::push_heap(std::ranges::begin(r), std::ranges::end(r),
+                             std::move(comp), std::move(proj),
+                             std::move(policy));
+}
+
+/*
+ * move the top of the heap [first,last) to last - 1. Returns last.
+ * (see Base::pop_heap())
+ */
+template <std::random_access_iterator I, std::sentinel_for<I> S,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<I, Compare, Proj>
+constexpr I
+pop_heap(I first, S last, Compare comp = {}, Proj proj = {},
+         Policy policy = {})
+{
+    const I end{std::ranges::next(first, last)};
+
+    Base::pop_heap(first, end,
+                   HeapHelpers::projected_compare<Compare, Proj>{
+                       std::move(comp), std::move(proj)},
+                   std::move(policy));
+    return end;
+}
+
+template <std::ranges::random_access_range R,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<std::ranges::iterator_t<R>, Compare, Proj>
+constexpr std::ranges::borrowed_iterator_t<R>
+pop_heap(R &&r, Compare comp = {}, Proj proj = {}, Policy policy = {})
+{
+    return ranges::pop_heap(std::ranges::begin(r), std::ranges::end(r),
+                            std::move(comp), std::move(proj),
+                            std::move(policy));
+}
+
+/*
+ * move the element at pos to last - 1. Returns last.
+ */
+template <std::random_access_iterator I, std::sentinel_for<I> S,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<I, Compare, Proj>
+constexpr I
+pop_heap(I first, S last, I pos, Compare comp = {}, Proj proj = {},
+         Policy policy = {})
+{
+    const I end{std::ranges::next(first, last)};
+
+    Base::pop_heap(first, end, pos,
+                   HeapHelpers::projected_compare<Compare, Proj>{
+                       std::move(comp), std::move(proj)},
+                   std::move(policy));
+    return end;
+}
+
+template <std::ranges::random_access_range R,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<std::ranges::iterator_t<R>, Compare, Proj>
+constexpr std::ranges::borrowed_iterator_t<R>
+pop_heap(R &&r, std::ranges::iterator_t<R> pos, Compare comp = {},
+         Proj proj = {}, Policy policy = {})
+{
+    return ranges::pop_heap(std::ranges::begin(r), std::ranges::end(r), pos,
+                            std::move(comp), std::move(proj),
+                            std::move(policy));
+}
+
+/*
+ * restore the heap condition after the priority of the changed element
+ * has been modified. Returns last. (see Base::update_heap())
+ */
+template <std::random_access_iterator I, std::sentinel_for<I> S,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<I, Compare, Proj>
+constexpr I
+update_heap(I first, S last, I changed, Compare comp = {}, Proj proj = {},
+            Policy policy = {})
+{
+    const I end{std::ranges::next(first, last)};
+
+    Base::update_heap(first, end, changed,
+                      HeapHelpers::projected_compare<Compare, Proj>{
+                          std::move(comp), std::move(proj)},
+                      std::move(policy));
+    return end;
+}
+
+template <std::ranges::random_access_range R,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<std::ranges::iterator_t<R>, Compare, Proj>
+constexpr std::ranges::borrowed_iterator_t<R>
+update_heap(R &&r, std::ranges::iterator_t<R> changed, Compare comp = {},
+            Proj proj = {}, Policy policy = {})
+{
+    return ranges::update_heap(std::ranges::begin(r), std::ranges::end(r),
+                               changed, std::move(comp), std::move(proj),
+                               std::move(policy));
+}
+
+/*
+ * make [first,last) into a heap. Returns last. (see Base::make_heap())
+ */
+template <std::random_access_iterator I, std::sentinel_for<I> S,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<I, Compare, Proj>
+constexpr I
+make_heap(I first, S last, Compare comp = {}, Proj proj = {},
+          Policy policy = {})
+{
+    const I end{std::ranges::next(first, last)};
+
+    Base::make_heap(first, end,
+                    HeapHelpers::projected_compare<Compare, Proj>{
+                        std::move(comp), std::move(proj)},
+                    std::move(policy));
+    return end;
+}
+
+template <std::ranges::random_access_range R,
+          typename Compare = std::ranges::less, typename Proj = std::identity,
+          HeapPolicy Policy = default_policy>
+requires std::sortable<std::ranges::iterator_t<R>, Compare, Proj>
+constexpr std::ranges::borrowed_iterator_t<R>
+make_heap(R &&r, Compare comp = {}, Proj proj = {}, Policy policy = {})
+{
+    return ranges::make_heap(std::ranges::begin(r), std::ranges::end(r),
+                             std::move(comp), std::move(proj),
+                             std::move(policy));
+}
+
+/*
+ * first element breaking the heap condition or whose recorded position is
+ * not its slot. (see Base::is_heap_until())
+ */
+template <std::random_access_iterator I, std::sentinel_for<I> S,
+          typename Proj = std::identity,
+          std::indirect_strict_weak_order<std::projected<I, Proj> > Compare =
+              std::ranges::less,
+          HeapPolicy Policy = default_policy>
+constexpr I
+is_heap_until(I first, S last, Compare comp = {}, Proj proj = {},
+              Policy policy = {})
+{
+    return Base::is_heap_until(first, std::ranges::next(first, last),
+                               HeapHelpers::projected_compare<Compare, Proj>{
+                                   std::move(comp), std::move(proj)},
+                               std::move(policy));
+}
+
+template <std::ranges::random_access_range R, typename Proj = std::identity,
+          std::indirect_strict_weak_order<
+              std::projected<std::ranges::iterator_t<R>, Proj> > Compare =
+              std::ranges::less,
+          HeapPolicy Policy = default_policy>
+constexpr std::ranges::borrowed_iterator_t<R>
+is_heap_until(R &&r, Compare comp = {}, Proj proj = {}, Policy policy = {})
+{
+    return ranges::is_heap_until(std::ranges::begin(r), std::ranges::end(r),
+                                 std::move(comp), std::move(proj),
+                                 std::move(policy));
+}
+
+template <std::ranges::random_access_range R, typename Proj = std::identity,
+          std::indirect_strict_weak_order<
+              std::projected<std::ranges::iterator_t<R>, Proj> > Compare =
+              std::ranges::less,
+          HeapPolicy Policy = default_policy>
+constexpr bool
+verify_heap(R &&r, Compare comp = {}, Proj proj = {}, Policy policy = {})
+{
+    return ranges::is_heap_until(r, std::move(comp), std::move(proj),
+                                 std::move(policy)) == std::ranges::end(r);
+}
+}
+}
+
+#endif
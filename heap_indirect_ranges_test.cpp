@@ -0,0 +1,162 @@
+/*
+ * indirect heap algorithms ranges interface test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g heap_indirect_ranges_test.cpp
+ */
+
+#include <array>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "heap_indirect_ranges.h"
+#include "priority_queue_indirect.h"
+
+struct Timer
+{
+    char   deadline;
+    size_t pos{};
+};
+
+/*
+ * provide function required by Base::ranges::push_heap(),
+ * Base::ranges::pop_heap()
+ */
+inline void setHeapIndex(Timer *t, size_t idx)
+{
+    t->pos = idx;
+}
+
+/*
+ * heap of values recording their position through a projection
+ */
+struct Task
+{
+    char     deadline;
+    unsigned pos{};
+};
+
+struct TaskCmp
+{
+    constexpr bool operator()(const Task &lhs, const Task &rhs) const
+    {
+        return lhs.deadline > rhs.deadline;
+    }
+};
+
+template <typename Range>
+void printTimers(const Range &r)
+{
+    for (const auto *t : r)
+        std::cout << t->deadline << ' ';
+    std::cout << '\n';
+    for (const auto *t : r)
+        std::cout << t->pos << ' ';
+    std::cout << '\n';
+}
+
+template <typename Range>
+void printTasks(const Range &r)
+{
+    for (const auto &t : r)
+        std::cout << t.deadline << ' ';
+    std::cout << '\n';
+    for (const auto &t : r)
+        std::cout << t.pos << ' ';
+    std::cout << '\n';
+}
+
+/*
+ * static schedule built at compile time
+ */
+constexpr auto makeSchedule()
+{
+    std::array<Task, 8> tasks{ Task{'S'}, Task{'C'}, Task{'H'}, Task{'E'},
+                               Task{'D'}, Task{'U'}, Task{'L'}, Task{'E'} };
+
+    Base::ranges::make_heap(tasks, std::ranges::greater{}, &Task::deadline,
+                            Base::projected_index_policy{&Task::pos});
+    return tasks;
+}
+
+constexpr auto schedule{makeSchedule()};
+
+static_assert(Base::ranges::verify_heap(schedule, std::ranges::greater{},
+                                        &Task::deadline,
+                                        Base::projected_index_policy{&Task::pos}));
+static_assert(schedule.front().deadline == 'C');
+
+int main()
+{
+    std::vector<Timer>   timers{ {'E'}, {'A'}, {'S'}, {'Y'}, {'Q'}, {'U'},
+                                 {'E'}, {'S'}, {'T'}, {'I'}, {'O'}, {'N'} };
+    std::vector<Timer *> heap;
+
+    for (auto &t : timers) {
+        heap.push_back(&t);
+        Base::ranges::push_heap(heap, std::ranges::greater{}, &Timer::deadline);
+    }
+    std::cout << "min-heap insert(EASYQUESTION):\n";
+    printTimers(heap);
+
+    std::cout << "\npop:\n";
+    Base::ranges::pop_heap(heap, std::ranges::greater{}, &Timer::deadline);
+    heap.pop_back();
+    printTimers(heap);
+
+    std::cout << "\nremove U at pos " << timers[5].pos << ":\n";
+    Base::ranges::pop_heap(heap, heap.begin() + timers[5].pos,
+                           std::ranges::greater{}, &Timer::deadline);
+    heap.pop_back();
+    printTimers(heap);
+
+    /*
+     * values recording their position through a projection
+     */
+    const Base::projected_index_policy taskPolicy{&Task::pos};
+    std::vector<Task> tasks{ {'E'}, {'A'}, {'S'}, {'Y'}, {'Q'}, {'U'},
+                             {'E'}, {'S'}, {'T'}, {'I'}, {'O'}, {'N'} };
+
+    Base::ranges::make_heap(tasks, {}, &Task::deadline, taskPolicy);
+    std::cout << "\nmax-heap make_heap(EASYQUESTION):\n";
+    printTasks(tasks);
+
+    std::cout << "\nchange A at pos 8 to Z:\n";
+    tasks[8].deadline = 'Z';
+    Base::ranges::update_heap(tasks, tasks.begin() + 8, {}, &Task::deadline,
+                              taskPolicy);
+    printTasks(tasks);
+
+    std::cout << "verify_heap: "
+              << Base::ranges::verify_heap(tasks, {}, &Task::deadline, taskPolicy)
+              << '\n';
+    Base::set_heap_index(tasks[3], 7, &Task::pos);
+    std::cout << "stale position at pos 3, is_heap_until: "
+              << Base::ranges::is_heap_until(tasks, {}, &Task::deadline,
+                                             taskPolicy) - tasks.begin()
+              << '\n';
+
+    /*
+     * queue of values locating them through the projection
+     */
+    using TaskPolicy = Base::projected_index_policy<unsigned Task::*>;
+    Base::IndirectPriorityQueue<Task, TaskCmp, std::vector<Task>, TaskPolicy>
+        taskQ(TaskCmp{}, TaskPolicy{&Task::pos});
+
+    for (char c : {'E', 'A', 'S', 'Y', 'Q', 'U'})
+        taskQ.push({c});
+    std::cout << "\nqueue erase(S):\n";
+    for (const auto &t : taskQ.container()) {
+        if (t.deadline == 'S') {
+            taskQ.erase(t);
+            break;
+        }
+    }
+    printTasks(taskQ.container());
+
+    std::cout << "\ncompile-time schedule:\n";
+    printTasks(schedule);
+
+    return 0;
+}
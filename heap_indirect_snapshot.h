@@ -0,0 +1,202 @@
+#ifndef HEAP_INDIRECT_SNAPSHOT_H_
+#define HEAP_INDIRECT_SNAPSHOT_H_
+/*
+ * Indirect heap snapshots
+ * https://github.com/lano1106/indirect_heap
+ *
+ * saves the order of a heap array as element ids so that a restarted
+ * process reinstates its heap in O(n) without a single comparison instead
+ * of rebuilding it, ie: millions of persisted timers. The elements
+ * themselves are persisted by the application, the snapshot only maps the
+ * heap positions to their ids.
+ *
+ * A snapshot is a heap_snapshot_header followed by the ids in heap order,
+ * in the native byte order. It is written to a buffer or a stream and read
+ * back from a stream or viewed in place, ie: from a mapped file:
+ *
+ * Base::write_heap_snapshot<uint32_t>(out, q.container().begin(),
+ *                                     q.container().end(),
+ *                                     [](const Timer *t){ return t->id; });
+ *
+ * Base::heap_snapshot_view<uint32_t> snap{addr, len};
+ * if (snap.valid()) {
+ *     auto elems{snap.ids() | std::views::transform(
+ *                    [&](uint32_t id){ return &timers[id]; })};
+ *     q.restore(elems.begin(), elems.end());
+ * }
+ *
+ * Restore with validation if the priorities may have changed since the
+ * snapshot. (see Base::restore_heap_checked())
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <span>
+#include <vector>
+
+namespace Base {
+
+namespace HeapHelpers {
+// "HEAPSNAP": a snapshot of the other byte order does not match
+inline constexpr std::uint64_t SnapshotMagic   = 0x50414e5350414548;
+inline constexpr std::uint32_t SnapshotVersion = 1;
+
+// ids moved at once from and to a stream
+inline constexpr std::size_t SnapshotChunk = 1024;
+}
+
+struct heap_snapshot_header
+{
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t id_size;
+    std::uint64_t count;
+
+    template <typename Id>
+    static constexpr heap_snapshot_header make(std::uint64_t count) noexcept
+    {
+        return {HeapHelpers::SnapshotMagic, HeapHelpers::SnapshotVersion,
+                sizeof(Id), count};
+    }
+
+    template <typename Id>
+    constexpr bool matches() const noexcept
+    {
+        return magic == HeapHelpers::SnapshotMagic &&
+               version == HeapHelpers::SnapshotVersion && id_size == sizeof(Id);
+    }
+};
+
+/*
+ * bytes of the snapshot of a heap of count elements
+ */
+template <typename Id>
+constexpr std::size_t heap_snapshot_size(std::size_t count) noexcept
+{
+    return sizeof(heap_snapshot_header) + count * sizeof(Id);
+}
+
+/*
+ * write the snapshot of the heap [first,last) to buf, which must hold
+ * heap_snapshot_size<Id>(last - first) bytes. idOf(element) returns the
+ * id of an element. Returns the end of the snapshot.
+ */
+template <typename Id, typename InputIterator, typename IdOf>
+std::byte *write_heap_snapshot(std::byte *buf, InputIterator first,
+                               InputIterator last, IdOf idOf)
+{
+    std::byte     *p{buf + sizeof(heap_snapshot_header)};
+    std::uint64_t  count{};
+
+    for (; first != last; ++first, ++count) {
+        const Id id{static_cast<Id>(idOf(*first))};
+
+        std::memcpy(p, &id, sizeof(Id));
+        p += sizeof(Id);
+    }
+
+    const auto header{heap_snapshot_header::make<Id>(count)};
+
+    std::memcpy(buf, &header, sizeof(header));
+    return p;
+}
+
+/*
+ * write the snapshot of the heap [first,last) to os, ie: a std::ofstream
+ * opened in binary mode. Returns false if the write failed.
+ */
+template <typename Id, typename ForwardIterator, typename IdOf>
+bool write_heap_snapshot(std::ostream &os, ForwardIterator first,
+                         ForwardIterator last, IdOf idOf)
+{
+    const auto header{heap_snapshot_header::make<Id>(
+        static_cast<std::uint64_t>(std::distance(first, last)))};
+    Id chunk[HeapHelpers::SnapshotChunk];
+
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    while (first != last && os) {
+        std::size_t n{};
+
+        for (; n < HeapHelpers::SnapshotChunk && first != last; ++first)
+            chunk[n++] = static_cast<Id>(idOf(*first));
+        os.write(reinterpret_cast<const char *>(chunk),
+                 static_cast<std::streamsize>(n * sizeof(Id)));
+    }
+    return static_cast<bool>(os);
+}
+
+/*
+ * read the ids of a snapshot written to is. Returns false if is does not
+ * hold a complete snapshot of Id ids.
+ */
+template <typename Id>
+bool read_heap_snapshot(std::istream &is, std::vector<Id> &ids)
+{
+    heap_snapshot_header header;
+
+    ids.clear();
+    if (!is.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        !header.matches<Id>())
+        return false;
+    // grow with the data read, a corrupted count must not allocate it all
+    while (ids.size() < header.count) {
+        const std::size_t n{static_cast<std::size_t>(std::min<std::uint64_t>(
+            HeapHelpers::SnapshotChunk, header.count - ids.size()))};
+        const std::size_t old{ids.size()};
+
+        ids.resize(old + n);
+        if (!is.read(reinterpret_cast<char *>(ids.data() + old),
+                     static_cast<std::streamsize>(n * sizeof(Id)))) {
+            ids.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * snapshot read in place, ie: from a mapped file. The ids are not copied,
+ * so buf must outlive the view and be aligned for Id, as a mapping is.
+ */
+template <typename Id>
+class heap_snapshot_view
+{
+public:
+    heap_snapshot_view(const void *buf, std::size_t size) noexcept
+    {
+        heap_snapshot_header header;
+
+        if (size < sizeof(header) ||
+            reinterpret_cast<std::uintptr_t>(buf) % alignof(Id))
+            return;
+        std::memcpy(&header, buf, sizeof(header));
+        if (!header.matches<Id>() ||
+            header.count > (size - sizeof(header)) / sizeof(Id))
+            return;
+        m_ids = std::span<const Id>(
+            reinterpret_cast<const Id *>(static_cast<const std::byte *>(buf) +
+                                         sizeof(header)),
+            static_cast<std::size_t>(header.count));
+        m_valid = true;
+    }
+
+    /*
+     * false if buf does not hold a complete snapshot of Id ids
+     */
+    bool valid() const noexcept { return m_valid; }
+
+    // ids in heap order
+    std::span<const Id> ids() const noexcept { return m_ids; }
+
+private:
+    std::span<const Id> m_ids;
+    bool                m_valid{};
+};
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * indirect heap snapshots test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g heap_indirect_snapshot_test.cpp
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <ranges>
+#include <sstream>
+#include <string_view>
+#include <vector>
+#include "heap_indirect_snapshot.h"
+#include "priority_queue_indirect.h"
+
+struct Timer
+{
+    char          deadline;
+    std::uint32_t id;
+    size_t        pos{};
+};
+
+/*
+ * provide functions required by Base::IndirectPriorityQueue
+ */
+inline void setHeapIndex(Timer *t, size_t idx)
+{
+    t->pos = idx;
+}
+
+inline size_t getHeapIndex(const Timer *t)
+{
+    return t->pos;
+}
+
+struct TimerCmp
+{
+    bool operator()(const Timer *lhs, const Timer *rhs) const
+    {
+        return lhs->deadline > rhs->deadline;
+    }
+};
+
+using CountedPolicy = Base::instrumented_policy<Base::heap_counters>;
+using TimerQueue    = Base::IndirectPriorityQueue<Timer *, TimerCmp,
+                                                  std::vector<Timer *>,
+                                                  CountedPolicy>;
+
+void printQueue(const TimerQueue &q)
+{
+    for (const auto *t : q.container())
+        std::cout << t->deadline << ' ';
+    std::cout << '\n';
+    for (const auto *t : q.container())
+        std::cout << t->pos << ' ';
+    std::cout << '\n';
+}
+
+std::vector<Timer> makeTimers()
+{
+    std::vector<Timer> timers;
+    std::uint32_t      id{};
+
+    for (char c : std::string_view{"EASYQUESTION"})
+        timers.push_back({c, id++});
+    return timers;
+}
+
+int main()
+{
+    std::vector<Timer>  timers{makeTimers()};
+    Base::heap_counters counters;
+    TimerQueue          q(TimerCmp{}, CountedPolicy{counters});
+
+    for (auto &t : timers)
+        q.push(&t);
+    std::cout << "insert(EASYQUESTION):\n";
+    printQueue(q);
+
+    const auto idOf{[](const Timer *t){ return t->id; }};
+    std::vector<std::byte> buf(Base::heap_snapshot_size<std::uint32_t>(q.size()));
+    std::stringstream      file;
+
+    Base::write_heap_snapshot<std::uint32_t>(buf.data(), q.container().begin(),
+                                             q.container().end(), idOf);
+    Base::write_heap_snapshot<std::uint32_t>(file, q.container().begin(),
+                                             q.container().end(), idOf);
+    std::cout << "\nsnapshot ids:\n";
+    for (auto id : Base::heap_snapshot_view<std::uint32_t>(buf.data(), buf.size()).ids())
+        std::cout << id << ' ';
+    std::cout << '\n';
+
+    /*
+     * restart: the timers are restored at their old positions without
+     * any comparison
+     */
+    std::vector<Timer> restarted{makeTimers()};
+    const auto         elemOf{[&](std::uint32_t id){ return &restarted[id]; }};
+
+    counters = {};
+    {
+        Base::heap_snapshot_view<std::uint32_t> snap(buf.data(), buf.size());
+        TimerQueue restoredQ(TimerCmp{}, CountedPolicy{counters});
+        auto       elems{snap.ids() | std::views::transform(elemOf)};
+
+        std::cout << "\nrestore from buffer:\n";
+        if (snap.valid())
+            restoredQ.restore(elems.begin(), elems.end());
+        printQueue(restoredQ);
+        std::cout << "compares: " << counters.compares
+                  << " index updates: " << counters.index_updates << '\n';
+    }
+
+    {
+        std::vector<std::uint32_t> ids;
+        TimerQueue restoredQ(TimerCmp{}, CountedPolicy{counters});
+        auto       elems{ids | std::views::transform(elemOf)};
+
+        counters = {};
+        std::cout << "\nrestore from stream, validated:\n";
+        if (Base::read_heap_snapshot(file, ids))
+            std::cout << "valid: " << restoredQ.restore(elems.begin(), elems.end(), true) << '\n';
+        printQueue(restoredQ);
+        std::cout << "ops: " << counters.ops << " compares: " << counters.compares
+                  << " index updates: " << counters.index_updates << '\n';
+    }
+
+    /*
+     * a priority changed since the snapshot: the heap is rebuilt
+     */
+    {
+        Base::heap_snapshot_view<std::uint32_t> snap(buf.data(), buf.size());
+        TimerQueue restoredQ(TimerCmp{}, CountedPolicy{counters});
+        auto       elems{snap.ids() | std::views::transform(elemOf)};
+
+        restarted[11].deadline = 'B';
+        counters = {};
+        std::cout << "\nrestore after changing N to B, validated:\n";
+        std::cout << "valid: " << restoredQ.restore(elems.begin(), elems.end(), true) << '\n';
+        printQueue(restoredQ);
+        std::cout << "ops: " << counters.ops << " compares: " << counters.compares
+                  << " index updates: " << counters.index_updates << '\n';
+    }
+
+    buf.resize(buf.size() - 1);
+    std::cout << "\ntruncated snapshot valid: "
+              << Base::heap_snapshot_view<std::uint32_t>(buf.data(), buf.size()).valid()
+              << "\nuint64_t ids snapshot valid: "
+              << Base::heap_snapshot_view<std::uint64_t>(buf.data(), buf.size()).valid()
+              << '\n';
+
+    return 0;
+}
@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <vector>
 #include "heap_indirect.h"
 
@@ -60,7 +61,8 @@ struct TestElem
 };
 
 /*
- * provide function required by Base::push_heap(), Base::pop_heap()
+ * provide functions required by Base::push_heap(), Base::pop_heap() and
+ * Base::is_heap_until()
  */
 template <typename ValType>
 inline void setHeapIndex(TestElem<ValType> *e, size_t idx)
@@ -68,6 +70,12 @@ inline void setHeapIndex(TestElem<ValType> *e, size_t idx)
     e->pos = idx;
 }
 
+template <typename ValType>
+inline size_t getHeapIndex(const TestElem<ValType> *e)
+{
+    return e->pos;
+}
+
 template <typename Iterator>
 void printTestVec(Iterator first, Iterator last)
 {
@@ -94,6 +102,26 @@ void printPtrTestVec(Iterator first, Iterator last)
     std::cout << '\n';
 }
 
+template <typename Iterator>
+void printKeyedTestVec(Iterator first, Iterator last)
+{
+    std::for_each(first, last, [](const auto &curItem){
+        std::cout << curItem.key << ' ';
+    });
+    std::cout << '\n';
+    std::for_each(first, last, [](const auto &curItem){
+        std::cout << static_cast<unsigned>(curItem.ptr->pos) << ' ';
+    });
+    std::cout << '\n';
+}
+
+void printCounters(const Base::heap_counters &c)
+{
+    std::cout << "ops: " << c.ops << " compares: " << c.compares
+              << " moves: " << c.moves << " index updates: " << c.index_updates
+              << " levels: " << c.levels << '\n';
+}
+
 int main(int argc, char *argv[])
 {
     auto comp{[](const auto *lhs, const auto *rhs){ return lhs->v > rhs->v; }};
@@ -218,6 +246,148 @@ int main(int argc, char *argv[])
     charVec    = origCharVec;
     charPtrVec = origCharPtrVec;
 
+    std::cout << "\nremove (bottom-up policy):\n";
+    Base::pop_heap(cpit, cpit+12, charCmp, Base::bottom_up_policy{});
+    printPtrTestVec(cpit, cpit+11);
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+
+    std::cout << "\nremove U at pos 2 (bottom-up policy):\n";
+    Base::pop_heap(cpit, cpit+12, cpit+2, charCmp, Base::bottom_up_policy{});
+    printPtrTestVec(cpit, cpit+11);
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+
+    std::cout << "\nremove (prefetch policy):\n";
+    Base::pop_heap(cpit, cpit+12, charCmp, Base::prefetch_policy<>{});
+    printPtrTestVec(cpit, cpit+11);
+
+    /*
+     * cost of the same removal with both sift strategies
+     */
+    Base::heap_counters counters;
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+
+    std::cout << "\nremove (instrumented):\n";
+    Base::pop_heap(cpit, cpit+12, charCmp,
+                   Base::instrumented_policy<Base::heap_counters>{counters});
+    printPtrTestVec(cpit, cpit+11);
+    printCounters(counters);
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+    counters   = {};
+
+    std::cout << "\nremove (instrumented bottom-up policy):\n";
+    Base::pop_heap(cpit, cpit+12, charCmp,
+                   Base::instrumented_policy<Base::heap_counters,
+                                             Base::bottom_up_sift>{counters});
+    printPtrTestVec(cpit, cpit+11);
+    printCounters(counters);
+
+    /*
+     * replacing the top costs a single sift instead of a pop and a push
+     */
+    TestElem<char> newElem{'V'};
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+    counters   = {};
+
+    std::cout << "\nreplace top by V (instrumented):\n";
+    const auto *oldTop{Base::replace_top(cpit, cpit+12, &newElem, charCmp,
+                                         Base::instrumented_policy<Base::heap_counters>{counters})};
+    std::cout << "old top: " << oldTop->v << '\n';
+    printPtrTestVec(cpit, cpit+12);
+    printCounters(counters);
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+    counters   = {};
+
+    std::cout << "\npop, push V (instrumented):\n";
+    Base::pop_heap(cpit, cpit+12, charCmp,
+                   Base::instrumented_policy<Base::heap_counters>{counters});
+    *(cpit+11) = &newElem;
+    Base::push_heap(cpit, cpit+12, charCmp,
+                    Base::instrumented_policy<Base::heap_counters>{counters});
+    printPtrTestVec(cpit, cpit+12);
+    printCounters(counters);
+
+    TestElem<char> zElem{'Z'};
+    TestElem<char> cElem{'C'};
+
+    std::cout << "\npush_pop Z, push_pop C:\n";
+    std::cout << Base::push_pop_heap(cpit, cpit+12, &zElem, charCmp)->v << ' ';
+    std::cout << Base::push_pop_heap(cpit, cpit+12, &cElem, charCmp)->v << '\n';
+    printPtrTestVec(cpit, cpit+12);
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+
+    std::vector<TestElem<char> *> expired;
+
+    std::cout << "\npop_until(>= Q):\n";
+    auto remaining{Base::pop_until(cpit, cpit+12,
+                                   [](const TestElem<char> *e){ return e->v >= 'Q'; },
+                                   std::back_inserter(expired), charCmp)};
+    for (const auto *e : expired)
+        std::cout << e->v << ' ';
+    std::cout << '\n';
+    printPtrTestVec(cpit, remaining);
+
+    /*
+     * pop_until() only switches to the bulk removal on large heaps, run it
+     * directly on the same heap. The result must be identical.
+     */
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+    expired.clear();
+
+    std::cout << "\nbulk pop_until(>= Q):\n";
+    {
+        auto isLate{[](const TestElem<char> *e){ return e->v >= 'Q'; }};
+        auto out{std::back_inserter(expired)};
+        Base::default_policy policy;
+        const auto len{Base::HeapHelpers::bulkPop(cpit, std::ptrdiff_t{12}, isLate,
+                                                  out, charCmp, policy)};
+
+        for (const auto *e : expired)
+            std::cout << e->v << ' ';
+        std::cout << '\n';
+        remaining = cpit + len;
+    }
+    printPtrTestVec(cpit, remaining);
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+    expired.clear();
+
+    std::cout << "\npop_until(>= Q) (bulk pop policy, 2 pops first):\n";
+    remaining = Base::pop_until(cpit, cpit+12,
+                                [](const TestElem<char> *e){ return e->v >= 'Q'; },
+                                std::back_inserter(expired), charCmp,
+                                Base::bulk_pop_policy<2, 0>{});
+    for (const auto *e : expired)
+        std::cout << e->v << ' ';
+    std::cout << '\n';
+    printPtrTestVec(cpit, remaining);
+
+    std::cout << "\npop_n(3):\n";
+    expired.clear();
+    remaining = Base::pop_n(cpit, remaining, 3, std::back_inserter(expired), charCmp);
+    for (const auto *e : expired)
+        std::cout << e->v << ' ';
+    std::cout << '\n';
+    printPtrTestVec(cpit, remaining);
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+
     std::cout << "\nchange A at pos 7 to V:\n";
     (*(cpit+7))->v = 'V';
     Base::upheap(cpit, cpit+12, cpit+7, charCmp);
@@ -228,5 +398,204 @@ int main(int argc, char *argv[])
     Base::downheap(cpit, cpit+12, cpit+1, charCmp);
     printPtrTestVec(cpit, cpit+12);
 
+    /*
+     * when the removed element and the last element are in different
+     * subtrees, the last element may have to move up to fill the hole.
+     */
+    std::vector<TestElem<char> > upVec{ {'Z'}, {'M'}, {'Y'}, {'A'}, {'B'}, {'X'} };
+    std::vector<TestElem<char> *> upPtrVec(Base::pointer_iterator{std::begin(upVec)},
+                                           Base::pointer_iterator{std::end(upVec)});
+    auto upit{std::begin(upPtrVec)};
+
+    for (size_t offset{2}; offset <= 6; ++offset)
+        Base::push_heap(upit, upit+offset, charCmp);
+    std::cout << "\ninsert(ZMYABX):\n";
+    printPtrTestVec(upit, upit+6);
+
+    std::cout << "\nremove A at pos 3:\n";
+    Base::pop_heap(upit, upit+6, upit+3, charCmp);
+    printPtrTestVec(upit, upit+5);
+
+    std::cout << "\nremove B at pos 4 (last):\n";
+    Base::pop_heap(upit, upit+5, upit+4, charCmp);
+    printPtrTestVec(upit, upit+4);
+
+    charVec    = origCharVec;
+    charPtrVec = origCharPtrVec;
+
+    std::cout << "\nmake_heap(EASYQUESTION):\n";
+    Base::make_heap(cpit, cpit+12, charCmp);
+    printPtrTestVec(cpit, cpit+12);
+
+    std::cout << "\nmake_heap_sorted(EASYQUESTION):\n";
+    std::sort(cpit, cpit+12, [&charCmp](const auto *lhs, const auto *rhs){
+        return charCmp(rhs, lhs);
+    });
+    Base::make_heap_sorted(cpit, cpit+12);
+    printPtrTestVec(cpit, cpit+12);
+
+    charVec    = origCharVec;
+    charPtrVec.assign(Base::pointer_iterator{std::begin(charVec)},
+                      Base::pointer_iterator{std::end(charVec)});
+    cpit = std::begin(charPtrVec);
+
+    std::cout << "\ninsert(EASYQU),insert_range(ESTION):\n";
+    Base::make_heap(cpit, cpit+6, charCmp);
+    Base::push_heap_range(cpit, cpit+6, cpit+12, charCmp);
+    printPtrTestVec(cpit, cpit+12);
+
+    std::cout << "\nmerge_heaps(EASYQU,ESTION):\n";
+    Base::make_heap(cpit, cpit+6, charCmp);
+    Base::make_heap(cpit+6, cpit+12, charCmp);
+    Base::merge_heaps(cpit, cpit+6, cpit+12, charCmp);
+    printPtrTestVec(cpit, cpit+12);
+
+    /*
+     * positions are checked along with the heap condition
+     */
+    std::cout << "\nverify_heap: " << Base::verify_heap(cpit, cpit+12, charCmp) << '\n';
+    cpit[5]->pos = 2;
+    std::cout << "stale position at pos 5, is_heap_until: "
+              << Base::is_heap_until(cpit, cpit+12, charCmp) - cpit << '\n';
+    cpit[5]->pos = 5;
+    cpit[9]->v = 'Z';
+    std::cout << "change E at pos 9 to Z, is_heap_until: "
+              << Base::is_heap_until(cpit, cpit+12, charCmp) - cpit << '\n';
+    Base::update_heap(cpit, cpit+12, cpit+9, charCmp);
+    std::cout << "update_heap, verify_heap: " << Base::verify_heap(cpit, cpit+12, charCmp) << '\n';
+
+    struct PrintCorrupt
+    {
+        void operator()(size_t pos) const
+        {
+            std::cout << "corrupted at pos " << pos << '\n';
+        }
+    };
+    using VerifyPolicy = Base::verify_policy<Base::default_policy, PrintCorrupt>;
+
+    std::cout << "\nremove (verify policy), stale position at pos 6:\n";
+    cpit[6]->pos = 1;
+    Base::pop_heap(cpit, cpit+12, charCmp, VerifyPolicy{});
+    printPtrTestVec(cpit, cpit+11);
+
+    /*
+     * same insertions with the keys cached in the heap array
+     */
+    using KeyedElem = Base::keyed_ptr<char, TestElem<char> >;
+    Base::key_compare<> keyCmp;
+    std::vector<KeyedElem> keyedVec;
+
+    charVec = origCharVec;
+    for (auto &e : charVec) {
+        keyedVec.push_back({e.v, &e});
+        Base::push_heap(keyedVec.begin(), keyedVec.end(), keyCmp);
+    }
+    std::cout << "\nkeyed insert(EASYQUESTION):\n";
+    printKeyedTestVec(keyedVec.begin(), keyedVec.end());
+
+    std::cout << "\nkeyed change A at pos 7 to V:\n";
+    keyedVec[7].ptr->v = 'V';
+    Base::update_key(keyedVec.begin(), keyedVec.end(), keyedVec.begin()+7,
+                     'V', keyCmp);
+    printKeyedTestVec(keyedVec.begin(), keyedVec.end());
+
+    std::cout << "\nkeyed change V at pos 1 to B:\n";
+    keyedVec[1].ptr->v = 'B';
+    Base::update_key(keyedVec.begin(), keyedVec.end(), keyedVec.begin()+1,
+                     'B', keyCmp);
+    printKeyedTestVec(keyedVec.begin(), keyedVec.end());
+
+    /*
+     * same exercise on a 4-ary heap
+     */
+    std::vector<TestElem<char> > char4Vec{ {'E'}, {'A'}, {'S'}, {'Y'},
+                                           {'Q'}, {'U'}, {'E'}, {'S'}, {'T'}, {'I'}, {'O'}, {'N'} };
+    std::vector<TestElem<char> *> char4PtrVec(Base::pointer_iterator{std::begin(char4Vec)},
+                                              Base::pointer_iterator{std::end(char4Vec)});
+    auto c4pit{std::begin(char4PtrVec)};
+
+    for (size_t offset{2}; offset <= 12; ++offset) {
+        std::cout << "\n4-ary insert(" << char4Vec[offset-1].v << "):\n";
+        Base::dary::push_heap<4>(c4pit, c4pit+offset, charCmp);
+        printPtrTestVec(c4pit, c4pit+offset);
+    }
+
+    std::cout << "\n4-ary remove at pos 2:\n";
+    Base::dary::pop_heap<4>(c4pit, c4pit+12, c4pit+2, charCmp);
+    printPtrTestVec(c4pit, c4pit+11);
+
+    std::cout << "\n4-ary remove:\n";
+    Base::dary::pop_heap<4>(c4pit, c4pit+11, charCmp);
+    printPtrTestVec(c4pit, c4pit+10);
+
+    std::cout << "\n4-ary remove (bottom-up policy):\n";
+    Base::dary::pop_heap<4>(c4pit, c4pit+10, charCmp, Base::bottom_up_policy{});
+    printPtrTestVec(c4pit, c4pit+9);
+
+    std::cout << "\n4-ary make_heap(EASYQUESTION):\n";
+    char4PtrVec.assign(Base::pointer_iterator{std::begin(char4Vec)},
+                       Base::pointer_iterator{std::end(char4Vec)});
+    c4pit = std::begin(char4PtrVec);
+    Base::dary::make_heap<4>(c4pit, c4pit+12, charCmp);
+    printPtrTestVec(c4pit, c4pit+12);
+
+    std::cout << "4-ary is_heap_until: "
+              << Base::dary::is_heap_until<4>(c4pit, c4pit+12, charCmp) - c4pit << '\n';
+    std::cout << "4-ary remove (verify policy), stale position at pos 7:\n";
+    c4pit[7]->pos = 3;
+    Base::dary::pop_heap<4>(c4pit, c4pit+12, charCmp, VerifyPolicy{});
+    printPtrTestVec(c4pit, c4pit+11);
+
+    /*
+     * 16-ary keyed heap with int64_t keys. With AVX2 or AVX-512 enabled,
+     * the best child is selected with SIMD instructions and the output
+     * must be identical to the scalar build.
+     */
+    using Keyed64Elem = Base::keyed_ptr<int64_t, TestElem<int64_t> >;
+    Base::key_compare<std::greater<> > minKeyCmp;
+    std::vector<TestElem<int64_t> > int64Vec;
+    std::vector<Keyed64Elem> keyed64Vec;
+
+    for (int64_t i{}; i < 40; ++i)
+        int64Vec.push_back({(i*37) % 41 - 20});
+    for (auto &e : int64Vec)
+        keyed64Vec.push_back({e.v, &e});
+    Base::dary::make_heap<16>(keyed64Vec.begin(), keyed64Vec.end(), minKeyCmp);
+    std::cout << "\n16-ary keyed make_heap:\n";
+    printKeyedTestVec(keyed64Vec.begin(), keyed64Vec.end());
+
+    std::cout << "\n16-ary keyed pop all:\n";
+    for (auto last{keyed64Vec.end()}; last != keyed64Vec.begin(); --last) {
+        std::cout << keyed64Vec.front().key << ' ';
+        Base::dary::pop_heap<16>(keyed64Vec.begin(), last, minKeyCmp);
+    }
+    std::cout << '\n';
+
+    /*
+     * B-heap with blocks of 2 levels: slots 0-2 hold the root block, the
+     * leaves 1 and 2 have their children in blocks 3-5, 6-8, 9-11...
+     */
+    std::vector<TestElem<char> > charBVec{ {'E'}, {'A'}, {'S'}, {'Y'},
+                                           {'Q'}, {'U'}, {'E'}, {'S'}, {'T'}, {'I'}, {'O'}, {'N'} };
+    std::vector<TestElem<char> *> charBPtrVec(Base::pointer_iterator{std::begin(charBVec)},
+                                              Base::pointer_iterator{std::end(charBVec)});
+    auto cbpit{std::begin(charBPtrVec)};
+
+    for (size_t offset{2}; offset <= 12; ++offset)
+        Base::bheap::push_heap<2>(cbpit, cbpit+offset, charCmp);
+    std::cout << "\nB-heap insert(EASYQUESTION):\n";
+    printPtrTestVec(cbpit, cbpit+12);
+
+    std::cout << "\nB-heap remove at pos 4:\n";
+    Base::bheap::pop_heap<2>(cbpit, cbpit+12, cbpit+4, charCmp);
+    printPtrTestVec(cbpit, cbpit+11);
+
+    std::cout << "\nB-heap pop all:\n";
+    for (auto last{cbpit+11}; last != cbpit; --last) {
+        std::cout << (*cbpit)->v << ' ';
+        Base::bheap::pop_heap<2>(cbpit, last, charCmp);
+    }
+    std::cout << '\n';
+
     return 0;
 }
@@ -0,0 +1,344 @@
+#ifndef PRIORITY_QUEUE_INDEXED_H_
+#define PRIORITY_QUEUE_INDEXED_H_
+/*
+ * Indexed priority queue
+ * https://github.com/lano1106/indirect_heap
+ *
+ * indirect priority queue of dense integer ids, for elements that cannot
+ * store their heap position. ie: third-party structs kept in a vector
+ * and identified by their index.
+ *
+ * The heap array holds 32 bits ids, the keys are kept in a side array
+ * indexed by id and the position of every id is recorded in an id to
+ * position table by the heap algorithms instead of calling
+ * setHeapIndex(). (see Base::handle_table_policy)
+ *
+ * The tables grow to the largest id pushed, so ids should be dense and
+ * start at 0. erase() and update() locate an id through the table in
+ * O(1) and restore the heap condition in O(log n).
+ *
+ * VertexPriorityQueue is the variant for graph searches (ie: Dijkstra, A*)
+ * over integer vertex ids. The keys are kept inline in the heap array next
+ * to the ids and the lowest key is on top by default. Unlike a
+ * std::priority_queue with lazy deletion, a vertex is never in the queue
+ * twice: decrease_key() moves it up in place.
+ *
+ * Policy is the heap policy passed to the heap algorithms.
+ * (see Base::heap_policy)
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "heap_indirect.h"
+
+namespace Base {
+
+template <typename Key,
+          typename Compare = std::less<Key>,
+          typename Policy  = Base::default_policy>
+class IndexedPriorityQueue
+{
+public:
+    using key_type       = Key;
+    using id_type        = std::uint32_t;
+    using key_compare    = Compare;
+    using policy_type    = Policy;
+    using container_type = std::vector<id_type>;
+    using size_type      = std::size_t;
+
+    // position of the ids that are not in the queue
+    static constexpr id_type npos = std::numeric_limits<id_type>::max();
+
+    IndexedPriorityQueue() = default;
+    explicit IndexedPriorityQueue(size_type ids,
+                                  const Compare &comp   = Compare(),
+                                  const Policy  &policy = Policy())
+    : m_keys(ids), m_pos(ids, npos), m_comp(comp), m_policy(policy) {}
+
+    [[nodiscard]] bool empty() const noexcept { return m_heap.empty(); }
+    size_type size() const noexcept { return m_heap.size(); }
+
+    // size of the id tables
+    size_type ids() const noexcept { return m_pos.size(); }
+    void reserve(size_type n) { m_heap.reserve(n); }
+
+    // make room for the ids in [0,n)
+    void resize(size_type n)
+    {
+        if (n > m_pos.size()) {
+            m_keys.resize(n);
+            m_pos.resize(n, npos);
+        }
+    }
+
+    void clear() noexcept
+    {
+        for (const id_type id : m_heap)
+            m_pos[id] = npos;
+        m_heap.clear();
+    }
+
+    bool contains(id_type id) const noexcept
+    {
+        return id < m_pos.size() && m_pos[id] != npos;
+    }
+
+    // position of id in container() or npos
+    id_type position(id_type id) const noexcept
+    {
+        return id < m_pos.size() ? m_pos[id] : npos;
+    }
+
+    id_type top() const { return m_heap.front(); }
+    const Key &top_key() const { return m_keys[m_heap.front()]; }
+
+    /*
+     * key of id. Only meaningful while id is in the queue.
+     */
+    const Key &key(id_type id) const { return m_keys[id]; }
+
+    /*
+     * id must not be in the queue.
+     */
+    void push(id_type id, const Key &key)
+    {
+        resize(size_type{id} + 1);
+        m_keys[id] = key;
+        m_heap.push_back(id);
+        Base::push_heap(m_heap.begin(), m_heap.end(), comp(), policy());
+    }
+
+    void pop()
+    {
+        const id_type id{m_heap.front()};
+
+        Base::pop_heap(m_heap.begin(), m_heap.end(), comp(), policy());
+        m_heap.pop_back();
+        m_pos[id] = npos;
+    }
+
+    /*
+     * remove id from the queue.
+     *
+     * id must be in the queue.
+     */
+    void erase(id_type id)
+    {
+        Base::pop_heap(m_heap.begin(), m_heap.end(),
+                       m_heap.begin() + m_pos[id], comp(), policy());
+        m_heap.pop_back();
+        m_pos[id] = npos;
+    }
+
+    /*
+     * change the key of id and restore the heap condition.
+     *
+     * id must be in the queue.
+     */
+    void update(id_type id, const Key &key)
+    {
+        m_keys[id] = key;
+        Base::update_heap(m_heap.begin(), m_heap.end(),
+                          m_heap.begin() + m_pos[id], comp(), policy());
+    }
+
+    /*
+     * give id the higher priority key and move it up.
+     *
+     * id must be in the queue and key must not have a lower priority than
+     * the current one.
+     */
+    void decrease_key(id_type id, const Key &key)
+    {
+        m_keys[id] = key;
+        Base::upheap(m_heap.begin(), m_heap.end(),
+                     m_heap.begin() + m_pos[id], comp(), policy());
+    }
+
+    const container_type &container() const noexcept { return m_heap; }
+
+private:
+    using IdCompare = Base::id_compare<Key, Compare>;
+    using IdPolicy  = Base::handle_table_policy<Policy, id_type>;
+
+    /*
+     * the tables may have been reallocated since the last operation so the
+     * functor and the policy are rebuilt for every one of them.
+     */
+    IdCompare comp() const noexcept { return {m_keys.data(), m_comp}; }
+    IdPolicy policy() { return IdPolicy{m_pos.data(), m_policy}; }
+
+    container_type       m_heap;
+    std::vector<Key>     m_keys;
+    std::vector<id_type> m_pos;
+    Compare              m_comp;
+    [[no_unique_address]] Policy m_policy;
+};
+
+template <typename Key     = double,
+          typename Compare = std::greater<Key>,
+          typename Policy  = Base::default_policy>
+class VertexPriorityQueue
+{
+public:
+    using key_type       = Key;
+    using id_type        = std::uint32_t;
+    using key_compare    = Compare;
+    using policy_type    = Policy;
+    using value_type     = Base::keyed_id<Key, id_type>;
+    using container_type = std::vector<value_type>;
+    using size_type      = std::size_t;
+
+    // position of the ids that are not in the queue
+    static constexpr id_type npos = std::numeric_limits<id_type>::max();
+
+    VertexPriorityQueue() = default;
+    explicit VertexPriorityQueue(size_type ids,
+                                 const Compare &comp   = Compare(),
+                                 const Policy  &policy = Policy())
+    : m_pos(ids, npos), m_comp{comp}, m_policy(policy) {}
+
+    [[nodiscard]] bool empty() const noexcept { return m_heap.empty(); }
+    size_type size() const noexcept { return m_heap.size(); }
+
+    // size of the position table
+    size_type ids() const noexcept { return m_pos.size(); }
+    void reserve(size_type n) { m_heap.reserve(n); }
+
+    // make room for the ids in [0,n)
+    void resize(size_type n)
+    {
+        if (n > m_pos.size())
+            m_pos.resize(n, npos);
+    }
+
+    void clear() noexcept
+    {
+        for (const auto &e : m_heap)
+            m_pos[e.id] = npos;
+        m_heap.clear();
+    }
+
+    bool contains(id_type id) const noexcept
+    {
+        return id < m_pos.size() && m_pos[id] != npos;
+    }
+
+    // position of id in container() or npos
+    id_type position(id_type id) const noexcept
+    {
+        return id < m_pos.size() ? m_pos[id] : npos;
+    }
+
+    id_type top() const { return m_heap.front().id; }
+    const Key &top_key() const { return m_heap.front().key; }
+
+    /*
+     * key of id.
+     *
+     * id must be in the queue.
+     */
+    const Key &key(id_type id) const { return m_heap[m_pos[id]].key; }
+
+    /*
+     * id must not be in the queue.
+     */
+    void push(id_type id, const Key &key)
+    {
+        resize(size_type{id} + 1);
+        m_heap.push_back({key, id});
+        Base::push_heap(m_heap.begin(), m_heap.end(), m_comp, policy());
+    }
+
+    void pop()
+    {
+        const id_type id{m_heap.front().id};
+
+        Base::pop_heap(m_heap.begin(), m_heap.end(), m_comp, policy());
+        m_heap.pop_back();
+        m_pos[id] = npos;
+    }
+
+    /*
+     * remove id from the queue.
+     *
+     * id must be in the queue.
+     */
+    void erase(id_type id)
+    {
+        Base::pop_heap(m_heap.begin(), m_heap.end(),
+                       m_heap.begin() + m_pos[id], m_comp, policy());
+        m_heap.pop_back();
+        m_pos[id] = npos;
+    }
+
+    /*
+     * change the key of id and restore the heap condition.
+     *
+     * id must be in the queue.
+     */
+    void update(id_type id, const Key &key)
+    {
+        const auto it{m_heap.begin() + m_pos[id]};
+
+        it->key = key;
+        Base::update_heap(m_heap.begin(), m_heap.end(), it, m_comp, policy());
+    }
+
+    /*
+     * give id the higher priority key and move it up.
+     *
+     * id must be in the queue and key must not have a lower priority than
+     * the current one.
+     */
+    void decrease_key(id_type id, const Key &key)
+    {
+        const auto it{m_heap.begin() + m_pos[id]};
+
+        it->key = key;
+        Base::upheap(m_heap.begin(), m_heap.end(), it, m_comp, policy());
+    }
+
+    /*
+     * edge relaxation: push id with key, or decrease its key when key has
+     * a higher priority. Returns false, leaving the queue untouched, when
+     * id is already in the queue with a key of higher or equal priority.
+     *
+     * ids popped before are pushed again. Searches that must not revisit
+     * them check their own settled state first.
+     */
+    bool push_or_decrease(id_type id, const Key &key)
+    {
+        const id_type pos{position(id)};
+
+        if (pos == npos) {
+            push(id, key);
+            return true;
+        }
+        if (!m_comp.comp(m_heap[pos].key, key))
+            return false;
+        decrease_key(id, key);
+        return true;
+    }
+
+    const container_type &container() const noexcept { return m_heap; }
+
+private:
+    using KeyCompare = Base::key_compare<Compare>;
+    using IdPolicy   = Base::handle_table_policy<Policy, id_type>;
+
+    // the position table may have been reallocated by a push
+    IdPolicy policy() { return IdPolicy{m_pos.data(), m_policy}; }
+
+    container_type       m_heap;
+    std::vector<id_type> m_pos;
+    KeyCompare           m_comp;
+    [[no_unique_address]] Policy m_policy;
+};
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * indexed priority queue test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g priority_queue_indexed_test.cpp
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "priority_queue_indexed.h"
+
+/*
+ * element that cannot store its heap position
+ */
+struct ThirdPartyElem
+{
+    char v;
+};
+
+using TestQueue = Base::IndexedPriorityQueue<char>;
+
+void printQueue(const TestQueue &q)
+{
+    for (const auto id : q.container())
+        std::cout << q.key(id) << ' ';
+    std::cout << '\n';
+    for (const auto id : q.container())
+        std::cout << id << ' ';
+    std::cout << '\n';
+    for (const auto id : q.container())
+        std::cout << q.position(id) << ' ';
+    std::cout << '\n';
+}
+
+int main()
+{
+    std::vector<ThirdPartyElem> elems{ {'E'}, {'A'}, {'S'}, {'Y'},
+                                       {'Q'}, {'U'}, {'E'}, {'S'}, {'T'}, {'I'}, {'O'}, {'N'} };
+    TestQueue q(elems.size());
+
+    for (std::uint32_t id{}; id < elems.size(); ++id)
+        q.push(id, elems[id].v);
+    std::cout << "insert(EASYQUESTION):\n";
+    printQueue(q);
+
+    std::cout << "\nerase(U), erase(Y):\n";
+    q.erase(5);
+    q.erase(3);
+    printQueue(q);
+    std::cout << "contains(Y): " << q.contains(3) << '\n';
+
+    std::cout << "\nupdate(A->Z), update(T->B):\n";
+    q.update(1, 'Z');
+    q.update(8, 'B');
+    printQueue(q);
+
+    std::cout << "\npush(id 20, X):\n";
+    q.push(20, 'X');
+    std::cout << "ids: " << q.ids() << " top: " << q.top()
+              << " position(20): " << q.position(20) << '\n';
+
+    std::cout << "\npop all:\n";
+    while (!q.empty()) {
+        std::cout << q.top_key() << ' ';
+        q.pop();
+    }
+    std::cout << '\n';
+
+    Base::heap_counters counters;
+    Base::IndexedPriorityQueue<char, std::less<char>,
+                               Base::instrumented_policy<Base::heap_counters> >
+        countedQ(elems.size(), {}, Base::instrumented_policy<Base::heap_counters>{counters});
+
+    for (std::uint32_t id{}; id < elems.size(); ++id)
+        countedQ.push(id, elems[id].v);
+    while (!countedQ.empty())
+        countedQ.pop();
+    std::cout << "\ninstrumented push/pop all:\n"
+              << "ops: " << counters.ops << " compares: " << counters.compares
+              << " index updates: " << counters.index_updates << '\n';
+
+    std::cout << "\ndecrease_key(N->Z):\n";
+    for (std::uint32_t id{}; id < elems.size(); ++id)
+        q.push(id, elems[id].v);
+    q.decrease_key(11, 'Z');
+    std::cout << "top: " << q.top() << ' ' << q.top_key() << '\n';
+    q.clear();
+
+    /*
+     * lowest key on top, relaxed like the edges of a shortest path search
+     */
+    Base::VertexPriorityQueue<std::uint32_t> vq(4);
+
+    vq.push(0, 7);
+    vq.push(1, 3);
+    vq.push(2, 5);
+    std::cout << "\nvertex push_or_decrease(2, 9): " << vq.push_or_decrease(2, 9)
+              << ", push_or_decrease(2, 1): " << vq.push_or_decrease(2, 1)
+              << ", push_or_decrease(3, 4): " << vq.push_or_decrease(3, 4) << '\n';
+    for (const auto &e : vq.container())
+        std::cout << e.id << ':' << e.key << ' ';
+    std::cout << '\n';
+    for (const auto &e : vq.container())
+        std::cout << vq.position(e.id) << ' ';
+    std::cout << '\n';
+
+    std::cout << "vertex pop all:\n";
+    while (!vq.empty()) {
+        std::cout << vq.top() << ':' << vq.top_key() << ' ';
+        vq.pop();
+    }
+    std::cout << "\ncontains(2): " << vq.contains(2) << '\n';
+
+    return 0;
+}
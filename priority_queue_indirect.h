@@ -0,0 +1,334 @@
+#ifndef PRIORITY_QUEUE_INDIRECT_H_
+#define PRIORITY_QUEUE_INDIRECT_H_
+/*
+ * Indirect priority queue
+ * https://github.com/lano1106/indirect_heap
+ *
+ * container adaptor around the indirect heap algorithms. In addition to the
+ * std::priority_queue interface, it offers erase() and update() of an
+ * arbitrary element in O(log n) by locating it through the position
+ * stored by setHeapIndex().
+ *
+ * value_type must provide the following functions, found by ADL:
+ *
+ * void   setHeapIndex(value_type &, size_t);
+ * size_t getHeapIndex(const value_type &);
+ *
+ * Policy is the heap policy passed to the heap algorithms.
+ * (see Base::heap_policy) A policy recording the positions itself, ie:
+ * Base::handle_table_policy or Base::projected_index_policy, replaces
+ * these functions.
+ *
+ * the pushed elements are stamped with an insertion sequence number when
+ * value_type provides, found by ADL:
+ *
+ * void          setHeapSequence(value_type &, std::uint64_t);
+ * std::uint64_t getHeapSequence(const value_type &);
+ *
+ * Compare it with Base::fifo_compare to pop equal priorities in insertion
+ * order. merge() and restore() keep the existing stamps.
+ */
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "heap_indirect.h"
+
+namespace Base {
+
+template <typename T,
+          typename Compare   = std::less<T>,
+          typename Container = std::vector<T>,
+          typename Policy    = Base::default_policy>
+class IndirectPriorityQueue
+{
+public:
+    using container_type  = Container;
+    using value_compare   = Compare;
+    using policy_type     = Policy;
+    using value_type      = typename Container::value_type;
+    using size_type       = typename Container::size_type;
+    using reference       = typename Container::reference;
+    using const_reference = typename Container::const_reference;
+
+    IndirectPriorityQueue() = default;
+    explicit IndirectPriorityQueue(const Compare &comp,
+                                   const Policy &policy = Policy())
+    : m_comp(comp), m_policy(policy) {}
+
+    // bulk construction in O(n)
+    template <typename InputIterator>
+    IndirectPriorityQueue(InputIterator first, InputIterator last,
+                          const Compare &comp   = Compare(),
+                          const Policy  &policy = Policy())
+    : m_c(first, last), m_comp(comp), m_policy(policy)
+    {
+        for (auto &v : m_c)
+            stamp(v);
+        Base::make_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return m_c.empty(); }
+    size_type size() const noexcept { return m_c.size(); }
+    void reserve(size_type n) { m_c.reserve(n); }
+    void clear() noexcept { m_c.clear(); }
+
+    const_reference top() const { return m_c.front(); }
+
+    void push(const value_type &v)
+    {
+        m_c.push_back(v);
+        stamp(m_c.back());
+        Base::push_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+    void push(value_type &&v)
+    {
+        m_c.push_back(std::move(v));
+        stamp(m_c.back());
+        Base::push_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+    template <typename... Args>
+    void emplace(Args &&...args)
+    {
+        m_c.emplace_back(std::forward<Args>(args)...);
+        stamp(m_c.back());
+        Base::push_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+    void pop()
+    {
+        Base::pop_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+        m_c.pop_back();
+    }
+
+    /*
+     * move the elements of other into the queue. other is left empty.
+     *
+     * the smaller queue is merged into the larger one, whose elements
+     * keep their positions. Both queues must order their elements the
+     * same way.
+     *
+     * the merged elements keep their stamps, so ties between elements of
+     * the 2 queues follow the order of their own pushes. The elements
+     * pushed afterwards are stamped after the elements of both queues.
+     */
+    void merge(IndirectPriorityQueue &&other)
+    {
+        if (other.m_c.size() > m_c.size())
+            m_c.swap(other.m_c);
+
+        const auto oldSize{m_c.size()};
+
+        m_c.insert(m_c.end(), std::make_move_iterator(other.m_c.begin()),
+                   std::make_move_iterator(other.m_c.end()));
+        other.m_c.clear();
+        m_seq       = std::max(m_seq, other.m_seq);
+        other.m_seq = 0;
+        Base::merge_heaps(m_c.begin(), m_c.begin() + oldSize, m_c.end(),
+                          m_comp, m_policy);
+    }
+
+    /*
+     * replace the content of the queue by [first,last), elements in the
+     * order of container() at the time of a snapshot. (see
+     * heap_indirect_snapshot.h)
+     *
+     * the positions are recorded without any comparison. With validate,
+     * the order is checked first and the heap is rebuilt if the
+     * priorities changed since. Returns false in that case.
+     *
+     * the restored elements keep their stamps. The elements pushed
+     * afterwards are stamped after them.
+     */
+    template <typename InputIterator>
+    bool restore(InputIterator first, InputIterator last, bool validate = false)
+    {
+        // ie: the iterators of a transform view are sized but input only
+        if constexpr (std::sized_sentinel_for<InputIterator, InputIterator>)
+            m_c.reserve(static_cast<size_type>(last - first));
+        m_c.assign(first, last);
+        if constexpr (stamped) {
+            // stamp the elements pushed afterwards after the restored ones
+            for (const auto &v : m_c)
+                m_seq = std::max<std::uint64_t>(m_seq, getHeapSequence(v) + 1);
+        }
+        if (validate)
+            return Base::restore_heap_checked(m_c.begin(), m_c.end(), m_comp,
+                                              m_policy);
+        Base::restore_heap(m_c.begin(), m_c.end(), m_policy);
+        return true;
+    }
+
+    /*
+     * pop the elements for which pred holds to out in priority order.
+     * Returns the number of elements popped. (see Base::pop_until())
+     */
+    template <typename Predicate, typename OutputIterator>
+    size_type pop_until(Predicate pred, OutputIterator out)
+    {
+        return shrink(Base::pop_until(m_c.begin(), m_c.end(), std::move(pred),
+                                      std::move(out), m_comp, m_policy));
+    }
+
+    /*
+     * pop up to n of the highest priority elements to out in priority
+     * order. Returns the number of elements popped.
+     */
+    template <typename OutputIterator>
+    size_type pop_n(size_type n, OutputIterator out)
+    {
+        return shrink(Base::pop_n(m_c.begin(), m_c.end(),
+                                  static_cast<typename Container::difference_type>(n),
+                                  std::move(out), m_comp, m_policy));
+    }
+
+    /*
+     * pop the top and push v with a single sift. Returns the former top.
+     *
+     * the queue must not be empty.
+     */
+    value_type replace_top(value_type v)
+    {
+        stamp(v);
+        return Base::replace_top(m_c.begin(), m_c.end(), std::move(v), m_comp,
+                                 m_policy);
+    }
+
+    /*
+     * push v and pop the top. Returns v itself, leaving the queue
+     * untouched, when it would be the new top.
+     *
+     * v is compared with the sequence number it would be stamped with,
+     * its own one is restored if it would be the new top.
+     */
+    value_type push_pop(value_type v)
+    {
+        if constexpr (stamped) {
+            const std::uint64_t seq{getHeapSequence(v)};
+
+            setHeapSequence(v, m_seq);
+            if (Base::try_replace_top(m_c.begin(), m_c.end(), v, m_comp,
+                                      m_policy))
+                ++m_seq;
+            else
+                setHeapSequence(v, seq);
+            return v;
+        }
+        else {
+            return Base::push_pop_heap(m_c.begin(), m_c.end(), std::move(v),
+                                       m_comp, m_policy);
+        }
+    }
+
+    /*
+     * replace the top by v unless v would be the new top, and move the
+     * former top to v. Returns false, leaving v and the queue untouched,
+     * otherwise.
+     *
+     * v is compared with the sequence number it would be stamped with,
+     * its own one is restored if it is rejected.
+     */
+    bool try_replace_top(value_type &v)
+    {
+        if constexpr (stamped) {
+            const std::uint64_t seq{getHeapSequence(v)};
+
+            setHeapSequence(v, m_seq);
+            if (!Base::try_replace_top(m_c.begin(), m_c.end(), v, m_comp,
+                                       m_policy)) {
+                setHeapSequence(v, seq);
+                return false;
+            }
+            ++m_seq;
+            return true;
+        }
+        else {
+            return Base::try_replace_top(m_c.begin(), m_c.end(), v, m_comp,
+                                         m_policy);
+        }
+    }
+
+    /*
+     * remove v from the queue.
+     *
+     * v must be in the queue.
+     */
+    void erase(const value_type &v)
+    {
+        const auto pos{static_cast<size_type>(
+            HeapHelpers::storedHeapIndex(v, m_policy))};
+
+        Base::pop_heap(m_c.begin(), m_c.end(), m_c.begin() + pos, m_comp,
+                       m_policy);
+        m_c.pop_back();
+    }
+
+    /*
+     * restore the heap condition after the priority of v has been
+     * modified.
+     *
+     * v must be in the queue.
+     */
+    void update(const value_type &v)
+    {
+        const auto pos{static_cast<size_type>(
+            HeapHelpers::storedHeapIndex(v, m_policy))};
+
+        Base::update_heap(m_c.begin(), m_c.end(), m_c.begin() + pos, m_comp,
+                          m_policy);
+    }
+
+    /*
+     * change the cached key of v (ie: Base::keyed_ptr) and restore the
+     * heap condition.
+     *
+     * v must be in the queue.
+     */
+    template <typename Key>
+    void update_key(const value_type &v, Key &&key)
+    {
+        const auto pos{static_cast<size_type>(
+            HeapHelpers::storedHeapIndex(v, m_policy))};
+
+        Base::update_key(m_c.begin(), m_c.end(), m_c.begin() + pos,
+                         std::forward<Key>(key), m_comp, m_policy);
+    }
+
+    const container_type &container() const noexcept { return m_c; }
+
+private:
+    static constexpr bool stamped =
+        requires (value_type &v, std::uint64_t seq) {
+            setHeapSequence(v, seq);
+            { getHeapSequence(std::as_const(v)) } -> std::convertible_to<std::uint64_t>;
+        };
+
+    void stamp(value_type &v)
+    {
+        if constexpr (stamped)
+            setHeapSequence(v, m_seq++);
+    }
+
+    // drop the popped elements after the new end of the heap
+    size_type shrink(typename Container::iterator last)
+    {
+        const auto n{static_cast<size_type>(m_c.end() - last)};
+
+        m_c.erase(last, m_c.end());
+        return n;
+    }
+
+    Container m_c;
+    Compare   m_comp;
+    [[no_unique_address]] Policy m_policy;
+    std::uint64_t m_seq{};
+};
+}
+
+#endif
@@ -0,0 +1,455 @@
+#ifndef PRIORITY_QUEUE_INDIRECT_CONCURRENT_H_
+#define PRIORITY_QUEUE_INDIRECT_CONCURRENT_H_
+/*
+ * Concurrent indirect priority queue
+ * https://github.com/lano1106/indirect_heap
+ *
+ * fixed capacity heap that can be used by many threads at once, based on:
+ * G. C. Hunt, M. M. Michael, S. Parthasarathy, M. L. Scott.
+ * An efficient algorithm for concurrent priority queue heaps (1996)
+ *
+ * Every heap node has its own lock. A single heap lock only protects the
+ * heap size and is held just long enough to reserve or release the last
+ * node. The sifts then lock at most 2 nodes at a time, always a parent
+ * before its child, so operations on different paths proceed in
+ * parallel:
+ *
+ * - push() fills the reserved node and sifts it up. The element is tagged
+ *   with the identity of the push so that it can be followed when a
+ *   concurrent pop() moves it.
+ * - pop() moves the last element in the root and sifts it down.
+ * - erase() locates the element through the position stored by
+ *   setHeapIndex() and validates under the node lock that it is still
+ *   there before removing it. The position is retried if the element has
+ *   been moved in the meantime.
+ *
+ * Nodes are allocated to the bottom level in bit-reversed order so that
+ * consecutive push() calls sift up along different paths.
+ *
+ * value_type is typically a pointer. It must be equality comparable and
+ * provide the following functions, found by ADL:
+ *
+ * void   setHeapIndex(value_type &, size_t);
+ * size_t getHeapIndex(const value_type &);
+ *
+ * erase() reads the position while other threads may be moving the
+ * element, so it should be stored in a std::atomic accessed with relaxed
+ * ordering. A stale position is detected by the validation. Positions are
+ * opaque to the caller. npos is recorded in an element that leaves the
+ * queue.
+ */
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace Base {
+
+namespace HeapHelpers {
+/*
+ * busy-wait that yields the CPU after a while in case the thread being
+ * waited for has been preempted.
+ */
+class backoff
+{
+public:
+    void wait() noexcept
+    {
+        if (m_spins < MaxSpins) {
+            ++m_spins;
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+        else
+            std::this_thread::yield();
+    }
+
+private:
+    static constexpr unsigned MaxSpins = 64;
+
+    unsigned m_spins{};
+};
+
+/*
+ * test and test-and-set lock. Node critical sections are a few
+ * instructions long, so spinning beats parking the thread.
+ */
+class spinlock
+{
+public:
+    void lock() noexcept
+    {
+        while (m_locked.exchange(true, std::memory_order_acquire)) {
+            backoff b;
+
+            while (m_locked.load(std::memory_order_relaxed))
+                b.wait();
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        return !m_locked.load(std::memory_order_relaxed) &&
+               !m_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() noexcept { m_locked.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> m_locked{false};
+};
+}
+
+template <typename T, typename Compare = std::less<T> >
+class ConcurrentIndirectPriorityQueue
+{
+public:
+    using value_compare = Compare;
+    using value_type    = T;
+    using size_type     = std::size_t;
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    explicit ConcurrentIndirectPriorityQueue(size_type capacity,
+                                             const Compare &comp = Compare())
+    : m_lastNode(lastNode(capacity)),
+      m_nodes(std::make_unique<Node[]>(m_lastNode + 1)),
+      m_capacity(capacity), m_comp(comp) {}
+
+    ConcurrentIndirectPriorityQueue(const ConcurrentIndirectPriorityQueue &) = delete;
+    ConcurrentIndirectPriorityQueue &operator=(const ConcurrentIndirectPriorityQueue &) = delete;
+
+    // may already be outdated when it returns
+    size_type size() const noexcept { return m_size.load(std::memory_order_relaxed); }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+    size_type capacity() const noexcept { return m_capacity; }
+
+    /*
+     * returns false if the queue is full.
+     */
+    bool push(const value_type &v)
+    {
+        const std::uint64_t tag{m_nextTag.fetch_add(1, std::memory_order_relaxed)};
+
+        m_heapLock.lock();
+        if (m_size.load(std::memory_order_relaxed) == m_capacity) {
+            m_heapLock.unlock();
+            return false;
+        }
+
+        const size_type i{position(m_size.load(std::memory_order_relaxed) + 1)};
+        Node &n{m_nodes[i]};
+
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        n.lock.lock();
+        m_heapLock.unlock();
+        n.item = v;
+        n.tag  = tag;
+        setHeapIndex(n.item, i);
+        n.lock.unlock();
+        siftUp(i, tag);
+        return true;
+    }
+
+    /*
+     * remove the highest priority element. Returns an empty optional if
+     * the queue is empty.
+     */
+    std::optional<value_type> pop()
+    {
+        m_heapLock.lock();
+
+        const size_type len{m_size.load(std::memory_order_relaxed)};
+
+        if (len == 0) {
+            m_heapLock.unlock();
+            return std::nullopt;
+        }
+
+        const size_type b{position(len)};
+        Node &bottom{m_nodes[b]};
+
+        m_size.store(len - 1, std::memory_order_relaxed);
+        bottom.lock.lock();
+        m_heapLock.unlock();
+
+        value_type v{std::move(bottom.item)};
+
+        bottom.tag = Empty;
+        bottom.lock.unlock();
+
+        Node &root{m_nodes[1]};
+
+        root.lock.lock();
+        // the last element was the root
+        if (root.tag == Empty) {
+            root.lock.unlock();
+            setHeapIndex(v, npos);
+            return v;
+        }
+        std::swap(v, root.item);
+        root.tag = Available;
+        setHeapIndex(root.item, 1);
+        m_nodes[siftDown(1)].lock.unlock();
+        setHeapIndex(v, npos);
+        return v;
+    }
+
+    /*
+     * remove v from the queue.
+     *
+     * returns false if v is not in the queue, ie: it has been popped by
+     * another thread. v must have been pushed at least once.
+     */
+    bool erase(const value_type &v)
+    {
+        HeapHelpers::backoff b;
+
+        for (;;) {
+            const size_type i{static_cast<size_type>(getHeapIndex(v))};
+
+            if (i == 0 || i > m_lastNode)
+                return false;
+
+            Node &n{m_nodes[i]};
+
+            n.lock.lock();
+            /*
+             * v has been moved since its position has been read, or it is
+             * in transit between 2 nodes. Its position is updated once it
+             * is placed, or set to npos if it has been popped.
+             *
+             * wait as well until a concurrent push() has placed v. The heap
+             * lock is taken before the node locks everywhere else:
+             * try_lock() it to avoid a deadlock.
+             */
+            if (n.tag != Available || !(n.item == v) ||
+                !m_heapLock.try_lock()) {
+                n.lock.unlock();
+                b.wait();
+                continue;
+            }
+            remove(i);
+            return true;
+        }
+    }
+
+private:
+    enum : std::uint64_t { Empty, Available, FirstTag };
+
+    struct Node
+    {
+        HeapHelpers::spinlock lock;
+        std::uint64_t         tag{Empty};
+        value_type            item{};
+    };
+
+    /*
+     * node of the len-th element. Nodes are numbered from 1 and each level
+     * is filled in bit-reversed order.
+     */
+    static size_type position(size_type len) noexcept
+    {
+        const int       level{static_cast<int>(std::bit_width(len)) - 1};
+        const size_type first{size_type{1} << level};
+        size_type       offset{len - first};
+        size_type       reversed{};
+
+        for (int b{}; b < level; ++b, offset >>= 1)
+            reversed = (reversed << 1) | (offset & 1);
+        return first + reversed;
+    }
+
+    /*
+     * the bottom level is not filled left to right, so all its nodes are
+     * allocated.
+     */
+    static size_type lastNode(size_type capacity) noexcept
+    {
+        return capacity ? 2 * std::bit_floor(capacity) - 1 : 0;
+    }
+
+    void swapNodes(Node &a, size_type ia, Node &b, size_type ib)
+    {
+        std::swap(a.item, b.item);
+        std::swap(a.tag, b.tag);
+        setHeapIndex(a.item, ia);
+        setHeapIndex(b.item, ib);
+    }
+
+    /*
+     * sift up the element pushed with tag from node i. Other operations
+     * may move it in the meantime, so the element is located by its tag at
+     * every level.
+     */
+    void siftUp(size_type i, std::uint64_t tag)
+    {
+        HeapHelpers::backoff b;
+
+        while (i > 1) {
+            const size_type p{i / 2};
+            const size_type cur{i};
+            Node &parent{m_nodes[p]};
+            Node &child{m_nodes[i]};
+
+            parent.lock.lock();
+            child.lock.lock();
+            if (parent.tag == Available && child.tag == tag) {
+                if (m_comp(parent.item, child.item)) {
+                    swapNodes(parent, p, child, i);
+                    i = p;
+                }
+                else {
+                    child.tag = Available;
+                    i = 0;
+                }
+            }
+            else if (parent.tag == Empty) {
+                // the element has been moved in the root by a pop()
+                i = 0;
+            }
+            else if (child.tag != tag) {
+                // the element has been moved up by a pop()
+                i = p;
+            }
+            /*
+             * else the parent is itself being pushed: retry once its push
+             * has moved on.
+             */
+            child.lock.unlock();
+            parent.lock.unlock();
+            if (i == cur)
+                b.wait();
+        }
+        if (i == 1) {
+            Node &root{m_nodes[1]};
+
+            root.lock.lock();
+            if (root.tag == tag)
+                root.tag = Available;
+            root.lock.unlock();
+        }
+    }
+
+    /*
+     * sift down the element in node i. Node i must be locked and is
+     * returned locked at the element final position.
+     */
+    size_type siftDown(size_type i)
+    {
+        for (;;) {
+            const size_type l{2 * i};
+            const size_type r{l + 1};
+
+            if (l > m_lastNode)
+                break;
+
+            Node &left{m_nodes[l]};
+
+            left.lock.lock();
+            if (left.tag == Empty) {
+                /*
+                 * nodes are filled left child first so the right child is
+                 * empty too.
+                 */
+                left.lock.unlock();
+                break;
+            }
+
+            size_type best{l};
+
+            if (r <= m_lastNode) {
+                Node &right{m_nodes[r]};
+
+                right.lock.lock();
+                if (right.tag != Empty && m_comp(left.item, right.item)) {
+                    left.lock.unlock();
+                    best = r;
+                }
+                else
+                    right.lock.unlock();
+            }
+
+            Node &cur{m_nodes[i]};
+            Node &child{m_nodes[best]};
+
+            if (!m_comp(cur.item, child.item)) {
+                child.lock.unlock();
+                break;
+            }
+            swapNodes(cur, i, child, best);
+            cur.lock.unlock();
+            i = best;
+        }
+        return i;
+    }
+
+    /*
+     * remove the element in node i. Node i and the heap lock must be
+     * locked. Releases both.
+     */
+    void remove(size_type i)
+    {
+        Node &n{m_nodes[i]};
+        const size_type len{m_size.load(std::memory_order_relaxed)};
+        const size_type b{position(len)};
+
+        m_size.store(len - 1, std::memory_order_relaxed);
+        setHeapIndex(n.item, npos);
+        if (b == i) {
+            m_heapLock.unlock();
+            n.tag = Empty;
+            n.lock.unlock();
+            return;
+        }
+
+        /*
+         * the last node is a leaf: a thread holding its lock never waits
+         * for another node lock, so locking it while holding node i
+         * cannot deadlock.
+         */
+        Node &bottom{m_nodes[b]};
+
+        bottom.lock.lock();
+        m_heapLock.unlock();
+        n.item = std::move(bottom.item);
+        bottom.tag = Empty;
+        bottom.lock.unlock();
+        n.tag = Available;
+        setHeapIndex(n.item, i);
+
+        /*
+         * the last element either sinks below node i or climbs above it
+         */
+        const size_type pos{siftDown(i)};
+
+        if (pos != i) {
+            m_nodes[pos].lock.unlock();
+            return;
+        }
+
+        const std::uint64_t tag{m_nextTag.fetch_add(1, std::memory_order_relaxed)};
+
+        n.tag = tag;
+        n.lock.unlock();
+        siftUp(i, tag);
+    }
+
+    const size_type            m_lastNode;
+    std::unique_ptr<Node[]>    m_nodes;
+    const size_type            m_capacity;
+    Compare                    m_comp;
+    HeapHelpers::spinlock      m_heapLock;
+    std::atomic<size_type>     m_size{0};
+    std::atomic<std::uint64_t> m_nextTag{FirstTag};
+};
+}
+
+#endif
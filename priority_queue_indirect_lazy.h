@@ -0,0 +1,266 @@
+#ifndef PRIORITY_QUEUE_INDIRECT_LAZY_H_
+#define PRIORITY_QUEUE_INDIRECT_LAZY_H_
+/*
+ * Indirect priority queue with lazy deletion
+ * https://github.com/lano1106/indirect_heap
+ *
+ * variant of Base::IndirectPriorityQueue for bursts of cancellations, ie:
+ * a client disconnecting with many open orders. erase() marks the element
+ * slot as dead in O(1) instead of sifting the heap:
+ *
+ * - dead elements are dropped when they reach the top, so top() is always
+ *   alive.
+ * - once the dead elements exceed a fraction of the heap (half by
+ *   default), the live ones are compacted and the heap is rebuilt in O(n).
+ *
+ * The tombstone is the top bit of the position recorded in the element,
+ * so the heap slots keep their size: getHeapIndex() of an erased element
+ * has it set and the positions must fit in the other bits. The
+ * comparisons still read the dead elements until they are dropped, so an
+ * erased element must stay valid and must not be pushed again until it
+ * is passed, as an rvalue, to the OnDiscard callback. Every erased
+ * element is passed to it exactly once, the dead elements still held by
+ * clear() and the destructor.
+ *
+ * value_type must provide the following functions, found by ADL:
+ *
+ * void   setHeapIndex(value_type &, size_t);
+ * size_t getHeapIndex(const value_type &);
+ *
+ * Policy is the heap policy passed to the heap algorithms.
+ * (see Base::heap_policy)
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "heap_indirect.h"
+
+namespace Base {
+
+namespace HeapHelpers {
+/*
+ * tombstone of an element: the top bit of its recorded position
+ */
+template <typename T>
+using lazy_index_t = std::make_unsigned_t<
+    std::remove_cvref_t<decltype(getHeapIndex(std::declval<const T &>()))> >;
+
+template <typename T>
+inline constexpr lazy_index_t<T> TombstoneBit =
+    lazy_index_t<T>{1} << (std::numeric_limits<lazy_index_t<T> >::digits - 1);
+
+/*
+ * keeps the tombstone of the elements moved by the heap algorithms
+ */
+template <typename Policy>
+struct lazy_policy : Policy
+{
+    explicit constexpr lazy_policy(const Policy &policy = Policy())
+    : Policy(policy) {}
+
+    template <typename T, typename Distance>
+    constexpr void recordHeapIndex(T &e, Distance k)
+    {
+        const auto index{static_cast<lazy_index_t<T> >(getHeapIndex(e))};
+
+        setHeapIndex(e, static_cast<lazy_index_t<T> >(k) |
+                        (index & TombstoneBit<T>));
+    }
+
+    template <typename T>
+    constexpr lazy_index_t<T> heapIndex(const T &e) const
+    {
+        return static_cast<lazy_index_t<T> >(getHeapIndex(e)) & ~TombstoneBit<T>;
+    }
+};
+}
+
+/*
+ * default discard callback
+ */
+struct ignore_discarded
+{
+    template <typename T>
+    constexpr void operator()(T &&) const noexcept {}
+};
+
+template <typename T,
+          typename Compare   = std::less<T>,
+          typename OnDiscard = Base::ignore_discarded,
+          typename Policy    = Base::default_policy>
+class LazyIndirectPriorityQueue
+{
+public:
+    using value_compare   = Compare;
+    using policy_type     = Policy;
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using const_reference = const T &;
+
+    LazyIndirectPriorityQueue() = default;
+    explicit LazyIndirectPriorityQueue(const Compare   &comp,
+                                       const OnDiscard &discard = OnDiscard(),
+                                       const Policy    &policy  = Policy())
+    : m_comp(comp), m_discard(discard), m_policy(policy) {}
+
+    LazyIndirectPriorityQueue(const LazyIndirectPriorityQueue &) = delete;
+    LazyIndirectPriorityQueue &operator=(const LazyIndirectPriorityQueue &) = delete;
+
+    ~LazyIndirectPriorityQueue() { clear(); }
+
+    [[nodiscard]] bool empty() const noexcept { return m_c.empty(); }
+
+    // live elements
+    size_type size() const noexcept { return m_c.size() - m_dead; }
+
+    // dead elements not yet dropped
+    size_type dead() const noexcept { return m_dead; }
+
+    void reserve(size_type n) { m_c.reserve(n); }
+
+    void clear()
+    {
+        for (auto &v : m_c) {
+            if (isDead(v))
+                m_discard(std::move(v));
+        }
+        m_c.clear();
+        m_dead = 0;
+    }
+
+    /*
+     * compact the heap once the dead elements exceed ratio of its slots.
+     * (0.5 by default)
+     */
+    void set_max_dead_ratio(double ratio) noexcept { m_maxDeadRatio = ratio; }
+
+    const_reference top() const { return m_c.front(); }
+
+    void push(const value_type &v)
+    {
+        m_c.push_back(v);
+        pushBack();
+    }
+
+    void push(value_type &&v)
+    {
+        m_c.push_back(std::move(v));
+        pushBack();
+    }
+
+    void pop()
+    {
+        Base::pop_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+        m_c.pop_back();
+        dropDeadTop();
+    }
+
+    /*
+     * mark v as dead. The top is removed and discarded right away.
+     *
+     * v must be in the queue and alive.
+     */
+    void erase(const value_type &v)
+    {
+        const size_type pos{position(v)};
+
+        if (pos == 0) {
+            Base::pop_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+            m_discard(std::move(m_c.back()));
+            m_c.pop_back();
+            dropDeadTop();
+            return;
+        }
+        setHeapIndex(m_c[pos], static_cast<Index>(pos) | Tombstone);
+        if (++m_dead > static_cast<size_type>(m_maxDeadRatio *
+                                               static_cast<double>(m_c.size())))
+            compact();
+    }
+
+    /*
+     * restore the heap condition after the priority of v has been
+     * modified.
+     *
+     * v must be in the queue and alive.
+     */
+    void update(const value_type &v)
+    {
+        const size_type pos{position(v)};
+
+        Base::update_heap(m_c.begin(), m_c.end(), m_c.begin() + pos, m_comp,
+                          m_policy);
+        dropDeadTop();
+    }
+
+    /*
+     * discard the dead elements and rebuild the heap from the live ones.
+     */
+    void compact()
+    {
+        // the live elements before the first dead one stay in place
+        auto live{std::find_if(m_c.begin(), m_c.end(), isDead)};
+
+        // a discarded element is not read again
+        for (auto it{live}; it != m_c.end(); ++it) {
+            if (isDead(*it))
+                m_discard(std::move(*it));
+            else
+                *live++ = std::move(*it);
+        }
+        m_c.erase(live, m_c.end());
+        m_dead = 0;
+        Base::make_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+private:
+    using Index       = HeapHelpers::lazy_index_t<T>;
+    using LazyPolicy  = HeapHelpers::lazy_policy<Policy>;
+
+    static constexpr Index Tombstone = HeapHelpers::TombstoneBit<T>;
+
+    static bool isDead(const value_type &v)
+    {
+        return static_cast<Index>(getHeapIndex(v)) & Tombstone;
+    }
+
+    static size_type position(const value_type &v)
+    {
+        return static_cast<Index>(getHeapIndex(v)) & ~Tombstone;
+    }
+
+    /*
+     * the tombstone is kept while the element moves: clear the one of a
+     * discarded element, or the npos of a new one, before the push.
+     */
+    void pushBack()
+    {
+        setHeapIndex(m_c.back(), static_cast<Index>(m_c.size() - 1));
+        Base::push_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+    // pops and updates can sink the top below dead elements
+    void dropDeadTop()
+    {
+        while (!m_c.empty() && isDead(m_c.front())) {
+            Base::pop_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+            --m_dead;
+            m_discard(std::move(m_c.back()));
+            m_c.pop_back();
+        }
+    }
+
+    std::vector<T> m_c;
+    Compare        m_comp;
+    [[no_unique_address]] OnDiscard  m_discard;
+    [[no_unique_address]] LazyPolicy m_policy;
+    size_type m_dead{};
+    double    m_maxDeadRatio{0.5};
+};
+}
+
+#endif
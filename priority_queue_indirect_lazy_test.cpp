@@ -0,0 +1,92 @@
+/*
+ * indirect priority queue with lazy deletion test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g priority_queue_indirect_lazy_test.cpp
+ */
+
+#include <iostream>
+#include <vector>
+#include "priority_queue_indirect_lazy.h"
+
+struct TestElem
+{
+    char   v;
+    size_t pos{};
+};
+
+/*
+ * provide functions required by Base::LazyIndirectPriorityQueue
+ */
+inline void setHeapIndex(TestElem *e, size_t idx)
+{
+    e->pos = idx;
+}
+
+inline size_t getHeapIndex(const TestElem *e)
+{
+    return e->pos;
+}
+
+struct TestElemCmp
+{
+    bool operator()(const TestElem *lhs, const TestElem *rhs) const
+    {
+        return lhs->v < rhs->v;
+    }
+};
+
+struct PrintDiscarded
+{
+    void operator()(TestElem *e) const
+    {
+        std::cout << "discarded " << e->v << '\n';
+    }
+};
+
+using TestQueue = Base::LazyIndirectPriorityQueue<TestElem *, TestElemCmp,
+                                                  PrintDiscarded>;
+
+int main()
+{
+    std::vector<TestElem> elems{ {'E'}, {'A'}, {'S'}, {'Y'},
+                                 {'Q'}, {'U'}, {'E'}, {'S'}, {'T'}, {'I'}, {'O'}, {'N'} };
+    TestQueue q;
+
+    for (auto &e : elems)
+        q.push(&e);
+    std::cout << "insert(EASYQUESTION), erase(U), erase(T), erase(A):\n";
+    q.erase(&elems[5]);
+    q.erase(&elems[8]);
+    q.erase(&elems[1]);
+    std::cout << "size: " << q.size() << " dead: " << q.dead() << '\n';
+
+    std::cout << "\nerase(Y) at the top:\n";
+    q.erase(&elems[3]);
+    std::cout << "top: " << q.top()->v << " size: " << q.size()
+              << " dead: " << q.dead() << '\n';
+
+    std::cout << "\npop 2:\n";
+    for (int i{}; i < 2; ++i) {
+        std::cout << "pop " << q.top()->v << '\n';
+        q.pop();
+    }
+    std::cout << "size: " << q.size() << " dead: " << q.dead() << '\n';
+
+    std::cout << "\nerase(E), erase(I), erase(E), more than half dead:\n";
+    q.erase(&elems[0]);
+    q.erase(&elems[9]);
+    q.erase(&elems[6]);
+    std::cout << "size: " << q.size() << " dead: " << q.dead() << '\n';
+
+    std::cout << "\npush(U) again, pop all:\n";
+    q.push(&elems[5]);
+    while (!q.empty()) {
+        std::cout << q.top()->v << ' ';
+        q.pop();
+    }
+    std::cout << '\n';
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#ifndef PRIORITY_QUEUE_INDIRECT_MINMAX_H_
+#define PRIORITY_QUEUE_INDIRECT_MINMAX_H_
+/*
+ * Indirect double-ended priority queue
+ * https://github.com/lano1106/indirect_heap
+ *
+ * container adaptor around the min-max heap algorithms (see Base::minmax).
+ * Both the highest and the lowest priority elements are available, ie:
+ * serve the earliest deadline and shed the furthest-out requests under
+ * overload, with a single position per element:
+ *
+ * - top() and pop_max() access the highest priority element.
+ * - bottom() and pop_min() access the lowest priority element.
+ * - erase() and update() locate an element through the position stored
+ *   by setHeapIndex() in O(log n).
+ *
+ * value_type must provide the following functions, found by ADL:
+ *
+ * void   setHeapIndex(value_type &, size_t);
+ * size_t getHeapIndex(const value_type &);
+ *
+ * Policy is the heap policy passed to the heap algorithms.
+ * (see Base::heap_policy) A policy recording the positions itself, ie:
+ * Base::handle_table_policy or Base::projected_index_policy, replaces
+ * these functions.
+ */
+
+#include <functional>
+#include <utility>
+#include <vector>
+#include "heap_indirect.h"
+
+namespace Base {
+
+template <typename T,
+          typename Compare   = std::less<T>,
+          typename Container = std::vector<T>,
+          typename Policy    = Base::default_policy>
+class MinMaxPriorityQueue
+{
+public:
+    using container_type  = Container;
+    using value_compare   = Compare;
+    using policy_type     = Policy;
+    using value_type      = typename Container::value_type;
+    using size_type       = typename Container::size_type;
+    using reference       = typename Container::reference;
+    using const_reference = typename Container::const_reference;
+
+    MinMaxPriorityQueue() = default;
+    explicit MinMaxPriorityQueue(const Compare &comp,
+                                 const Policy &policy = Policy())
+    : m_comp(comp), m_policy(policy) {}
+
+    // bulk construction in O(n)
+    template <typename InputIterator>
+    MinMaxPriorityQueue(InputIterator first, InputIterator last,
+                        const Compare &comp   = Compare(),
+                        const Policy  &policy = Policy())
+    : m_c(first, last), m_comp(comp), m_policy(policy)
+    {
+        Base::minmax::make_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return m_c.empty(); }
+    size_type size() const noexcept { return m_c.size(); }
+    void reserve(size_type n) { m_c.reserve(n); }
+    void clear() noexcept { m_c.clear(); }
+
+    // highest priority element
+    const_reference top() const { return m_c.front(); }
+
+    // lowest priority element
+    const_reference bottom() const
+    {
+        return *Base::minmax::min_element(m_c.begin(), m_c.end(), m_comp);
+    }
+
+    void push(const value_type &v)
+    {
+        m_c.push_back(v);
+        Base::minmax::push_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+    void push(value_type &&v)
+    {
+        m_c.push_back(std::move(v));
+        Base::minmax::push_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+    template <typename... Args>
+    void emplace(Args &&...args)
+    {
+        m_c.emplace_back(std::forward<Args>(args)...);
+        Base::minmax::push_heap(m_c.begin(), m_c.end(), m_comp, m_policy);
+    }
+
+    void pop_max()
+    {
+        Base::minmax::pop_max(m_c.begin(), m_c.end(), m_comp, m_policy);
+        m_c.pop_back();
+    }
+
+    void pop_min()
+    {
+        Base::minmax::pop_min(m_c.begin(), m_c.end(), m_comp, m_policy);
+        m_c.pop_back();
+    }
+
+    /*
+     * remove v from the queue.
+     *
+     * v must be in the queue.
+     */
+    void erase(const value_type &v)
+    {
+        const auto pos{static_cast<size_type>(
+            HeapHelpers::storedHeapIndex(v, m_policy))};
+
+        Base::minmax::pop_heap(m_c.begin(), m_c.end(), m_c.begin() + pos,
+                               m_comp, m_policy);
+        m_c.pop_back();
+    }
+
+    /*
+     * restore the heap condition after the priority of v has been
+     * modified.
+     *
+     * v must be in the queue.
+     */
+    void update(const value_type &v)
+    {
+        const auto pos{static_cast<size_type>(
+            HeapHelpers::storedHeapIndex(v, m_policy))};
+
+        Base::minmax::update_heap(m_c.begin(), m_c.end(), m_c.begin() + pos,
+                                  m_comp, m_policy);
+    }
+
+    const container_type &container() const noexcept { return m_c; }
+
+private:
+    Container m_c;
+    Compare   m_comp;
+    [[no_unique_address]] Policy m_policy;
+};
+}
+
+#endif
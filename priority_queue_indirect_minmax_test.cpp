@@ -0,0 +1,128 @@
+/*
+ * indirect double-ended priority queue test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g priority_queue_indirect_minmax_test.cpp
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include "priority_queue_indirect_minmax.h"
+
+struct TestElem
+{
+    char   v;
+    size_t pos{};
+};
+
+/*
+ * provide functions required by Base::MinMaxPriorityQueue
+ */
+inline void setHeapIndex(TestElem *e, size_t idx)
+{
+    e->pos = idx;
+}
+
+inline size_t getHeapIndex(const TestElem *e)
+{
+    return e->pos;
+}
+
+struct TestElemCmp
+{
+    bool operator()(const TestElem *lhs, const TestElem *rhs) const
+    {
+        return lhs->v < rhs->v;
+    }
+};
+
+using TestQueue = Base::MinMaxPriorityQueue<TestElem *, TestElemCmp>;
+
+void printQueue(const TestQueue &q)
+{
+    for (const auto *e : q.container())
+        std::cout << e->v << ' ';
+    std::cout << '\n';
+    for (const auto *e : q.container())
+        std::cout << e->pos << ' ';
+    std::cout << '\n';
+    if (!q.empty())
+        std::cout << "top: " << q.top()->v << " bottom: " << q.bottom()->v << '\n';
+}
+
+int main()
+{
+    std::vector<TestElem> elems{ {'E'}, {'A'}, {'S'}, {'Y'},
+                                 {'Q'}, {'U'}, {'E'}, {'S'}, {'T'}, {'I'}, {'O'}, {'N'} };
+    TestQueue q;
+
+    q.reserve(elems.size());
+    for (auto &e : elems)
+        q.push(&e);
+    std::cout << "insert(EASYQUESTION):\n";
+    printQueue(q);
+
+    std::cout << "\npop_min(), pop_max():\n";
+    q.pop_min();
+    q.pop_max();
+    printQueue(q);
+
+    std::cout << "\nerase(T):\n";
+    q.erase(&elems[8]);
+    printQueue(q);
+
+    std::cout << "\nupdate(U->B), update(E->Z):\n";
+    elems[5].v = 'B';
+    q.update(&elems[5]);
+    elems[0].v = 'Z';
+    q.update(&elems[0]);
+    printQueue(q);
+
+    std::cout << "\npop from both ends:\n";
+    while (!q.empty()) {
+        std::cout << q.top()->v << ' ';
+        q.pop_max();
+        if (q.empty())
+            break;
+        std::cout << q.bottom()->v << ' ';
+        q.pop_min();
+    }
+    std::cout << '\n';
+
+    std::vector<TestElem *> ptrs;
+    for (auto &e : elems)
+        ptrs.push_back(&e);
+    TestQueue bulkQ(ptrs.begin(), ptrs.end());
+    std::cout << "\nbulk construction:\n";
+    printQueue(bulkQ);
+
+    /*
+     * integer ids whose positions are recorded in a handle table
+     */
+    std::string_view      idStr{"EASYQUESTION"};
+    std::vector<char>     idKeys(idStr.begin(), idStr.end());
+    std::vector<uint32_t> idPos(idKeys.size());
+    using IdPolicy = Base::handle_table_policy<>;
+    Base::MinMaxPriorityQueue<uint32_t, Base::id_compare<char>,
+                              std::vector<uint32_t>, IdPolicy>
+        idQ(Base::id_compare<char>{idKeys.data()}, IdPolicy{idPos.data()});
+
+    for (uint32_t id{}; id < idKeys.size(); ++id)
+        idQ.push(id);
+    std::cout << "\nhandle table erase(Y), update(A->Z):\n";
+    idQ.erase(3);
+    idKeys[1] = 'Z';
+    idQ.update(1);
+    for (const auto id : idQ.container())
+        std::cout << idKeys[id] << ' ';
+    std::cout << '\n';
+    for (const auto id : idQ.container())
+        std::cout << idPos[id] << ' ';
+    std::cout << "\ntop: " << idKeys[idQ.top()] << " bottom: "
+              << idKeys[idQ.bottom()] << '\n';
+
+    return 0;
+}
@@ -0,0 +1,287 @@
+#ifndef PRIORITY_QUEUE_INDIRECT_MULTI_H_
+#define PRIORITY_QUEUE_INDIRECT_MULTI_H_
+/*
+ * Relaxed multi-queue of indirect heaps
+ * https://github.com/lano1106/indirect_heap
+ *
+ * MultiQueue from:
+ * H. Rihani, P. Sanders, R. Dementiev.
+ * MultiQueues: Simple Relaxed Concurrent Priority Queues (2015)
+ *
+ * c * P independent Base::IndirectPriorityQueue shards, each protected by
+ * its own lock, for P threads:
+ *
+ * - push() inserts in a random shard.
+ * - pop() removes the best of the tops of 2 random shards.
+ * - erase() removes an element from the shard that owns it in O(log n).
+ *
+ * Locks are only taken with try_lock(). A busy shard is replaced by
+ * another random one, so threads rarely wait for each other. erase() is
+ * the exception: only the shard that owns the element will do, so it
+ * backs off and tries it again. In exchange, pop() does not always
+ * return the highest priority element of the whole queue, only one that
+ * is close to it in the priority order. The more shards, the more
+ * relaxed the order.
+ *
+ * value_type must provide the following functions, found by ADL:
+ *
+ * void   setHeapIndex(value_type &, size_t);
+ * size_t getHeapIndex(const value_type &);
+ *
+ * The recorded value packs the position of the element in its shard and
+ * the shard id and is opaque to the caller. npos is recorded in an
+ * element that leaves the queue. erase() reads it while other threads may
+ * be moving the element, so it should be stored in a std::atomic accessed
+ * with relaxed ordering.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "priority_queue_indirect.h"
+#include "priority_queue_indirect_concurrent.h"
+
+namespace Base {
+
+namespace HeapHelpers {
+/*
+ * shard heap element: remembers the shard of the element to record it
+ * with the element position.
+ */
+template <typename T>
+struct shard_elem
+{
+    static constexpr unsigned    ShardBits = 16;
+    static constexpr std::size_t ShardMask = (std::size_t{1} << ShardBits) - 1;
+
+    T             value;
+    std::uint32_t shard;
+
+    friend void setHeapIndex(shard_elem &e, std::size_t idx)
+    {
+        setHeapIndex(e.value, (idx << ShardBits) | e.shard);
+    }
+
+    friend std::size_t getHeapIndex(const shard_elem &e)
+    {
+        return static_cast<std::size_t>(getHeapIndex(e.value)) >> ShardBits;
+    }
+};
+
+template <typename Compare>
+struct shard_elem_compare
+{
+    [[no_unique_address]] Compare comp;
+
+    template <typename T>
+    bool operator()(const shard_elem<T> &lhs, const shard_elem<T> &rhs) const
+    {
+        return comp(lhs.value, rhs.value);
+    }
+};
+
+/*
+ * per thread xorshift generator used to pick the shards
+ */
+inline std::uint64_t randomNumber() noexcept
+{
+    thread_local std::uint64_t state{
+        std::hash<std::thread::id>{}(std::this_thread::get_id()) |
+        1};
+
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+}
+
+template <typename T,
+          typename Compare = std::less<T>,
+          typename Policy  = Base::default_policy>
+class MultiQueue
+{
+public:
+    using value_compare = Compare;
+    using policy_type   = Policy;
+    using value_type    = T;
+    using size_type     = std::size_t;
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    /*
+     * numThreads * c shards. (between 2 and 65536)
+     */
+    explicit MultiQueue(size_type numThreads, size_type c = 2,
+                        const Compare &comp   = Compare(),
+                        const Policy  &policy = Policy())
+    : m_numShards(std::clamp<size_type>(numThreads * c, 2, Elem::ShardMask + 1)),
+      m_shards(std::make_unique<Shard[]>(m_numShards)),
+      m_comp{comp}
+    {
+        for (size_type i{}; i < m_numShards; ++i)
+            m_shards[i].q = ShardQueue(m_comp, policy);
+    }
+
+    MultiQueue(const MultiQueue &) = delete;
+    MultiQueue &operator=(const MultiQueue &) = delete;
+
+    // may already be outdated when it returns
+    size_type size() const noexcept { return m_size.load(std::memory_order_relaxed); }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+    size_type shards() const noexcept { return m_numShards; }
+
+    void push(const value_type &v)
+    {
+        HeapHelpers::backoff b;
+
+        for (;;) {
+            const std::uint32_t s{randomShard()};
+            Shard &shard{m_shards[s]};
+
+            if (shard.lock.try_lock()) {
+                m_size.fetch_add(1, std::memory_order_relaxed);
+                shard.q.push({v, s});
+                shard.lock.unlock();
+                return;
+            }
+            b.wait();
+        }
+    }
+
+    /*
+     * remove the best of the tops of 2 random shards. Returns an empty
+     * optional if the queue is empty.
+     */
+    std::optional<value_type> pop()
+    {
+        HeapHelpers::backoff b;
+
+        while (!empty()) {
+            const std::uint32_t s1{randomShard()};
+            std::uint32_t       s2{randomShard()};
+
+            if (s2 == s1)
+                s2 = (s1 + 1) % m_numShards;
+
+            Shard &first{m_shards[s1]};
+            Shard &second{m_shards[s2]};
+
+            if (!first.lock.try_lock()) {
+                b.wait();
+                continue;
+            }
+            if (!second.lock.try_lock()) {
+                first.lock.unlock();
+                b.wait();
+                continue;
+            }
+
+            Shard *best{&first};
+
+            if (first.q.empty() ||
+                (!second.q.empty() &&
+                 m_comp(first.q.top(), second.q.top())))
+                best = &second;
+
+            std::optional<value_type> res;
+
+            if (!best->q.empty()) {
+                res.emplace(best->q.top().value);
+                best->q.pop();
+                m_size.fetch_sub(1, std::memory_order_relaxed);
+            }
+            second.lock.unlock();
+            first.lock.unlock();
+            if (res) {
+                setHeapIndex(*res, npos);
+                return res;
+            }
+            // both shards were empty, try others
+        }
+        return std::nullopt;
+    }
+
+    /*
+     * remove v from the queue.
+     *
+     * returns false if v is not in the queue, ie: it has been popped by
+     * another thread. v must have been pushed at least once.
+     */
+    bool erase(const value_type &v)
+    {
+        HeapHelpers::backoff b;
+
+        for (;;) {
+            const auto idx{static_cast<size_type>(getHeapIndex(v))};
+
+            if (idx == npos)
+                return false;
+
+            const size_type s{idx & Elem::ShardMask};
+            Shard &shard{m_shards[s]};
+
+            // only the shard of v can be locked: wait for it
+            if (!shard.lock.try_lock()) {
+                b.wait();
+                continue;
+            }
+
+            /*
+             * v may have been popped and pushed in another shard since
+             * its position has been read.
+             */
+            const auto cur{static_cast<size_type>(getHeapIndex(v))};
+            const size_type pos{cur >> Elem::ShardBits};
+
+            if (cur == idx && pos < shard.q.size() &&
+                shard.q.container()[pos].value == v) {
+                shard.q.erase(shard.q.container()[pos]);
+                m_size.fetch_sub(1, std::memory_order_relaxed);
+                shard.lock.unlock();
+
+                value_type out{v};
+
+                setHeapIndex(out, npos);
+                return true;
+            }
+            shard.lock.unlock();
+            if (cur == npos)
+                return false;
+            b.wait();
+        }
+    }
+
+private:
+    using Elem        = HeapHelpers::shard_elem<T>;
+    using ElemCompare = HeapHelpers::shard_elem_compare<Compare>;
+    using ShardQueue  = IndirectPriorityQueue<Elem, ElemCompare,
+                                              std::vector<Elem>, Policy>;
+
+    struct alignas(64) Shard
+    {
+        HeapHelpers::spinlock lock;
+        ShardQueue            q;
+    };
+
+    std::uint32_t randomShard() const noexcept
+    {
+        return static_cast<std::uint32_t>(HeapHelpers::randomNumber() %
+                                          m_numShards);
+    }
+
+    const size_type          m_numShards;
+    std::unique_ptr<Shard[]> m_shards;
+    ElemCompare              m_comp;
+    std::atomic<size_type>   m_size{0};
+};
+}
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * indirect multi-queue test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g -pthread priority_queue_indirect_multi_test.cpp
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "priority_queue_indirect_multi.h"
+
+struct TestElem
+{
+    int                 v;
+    std::atomic<size_t> pos{Base::MultiQueue<TestElem *>::npos};
+    std::atomic<int>    removed{};
+};
+
+/*
+ * provide functions required by Base::MultiQueue
+ */
+inline void setHeapIndex(TestElem *e, size_t idx)
+{
+    e->pos.store(idx, std::memory_order_relaxed);
+}
+
+inline size_t getHeapIndex(const TestElem *e)
+{
+    return e->pos.load(std::memory_order_relaxed);
+}
+
+struct TestElemCmp
+{
+    bool operator()(const TestElem *lhs, const TestElem *rhs) const
+    {
+        return lhs->v < rhs->v;
+    }
+};
+
+using TestQueue = Base::MultiQueue<TestElem *, TestElemCmp>;
+
+int main()
+{
+    const char *str{"EASYQUESTION"};
+    std::vector<TestElem> elems(12);
+    TestQueue q(2);
+
+    for (size_t i{}; i < elems.size(); ++i) {
+        elems[i].v = str[i];
+        q.push(&elems[i]);
+    }
+    std::cout << "insert(EASYQUESTION) in " << q.shards() << " shards\n";
+
+    std::cout << "\nerase(U), erase(Y):\n";
+    std::cout << q.erase(&elems[5]) << ' ' << q.erase(&elems[3]) << '\n';
+    std::cout << "size: " << q.size() << '\n';
+    std::cout << "erase(Y) again: " << q.erase(&elems[3]) << '\n';
+
+    std::cout << "\npop all:\n";
+    size_t count{};
+    while (auto e = q.pop()) {
+        ++count;
+        (*e)->removed = 1;
+    }
+    bool all{true};
+    for (size_t i{}; i < elems.size(); ++i)
+        all = all && (i == 3 || i == 5 || elems[i].removed == 1);
+    std::cout << "popped: " << count << " all present: " << all << '\n';
+
+    /*
+     * every thread pushes its elements, erases a third of them and pops
+     * while the others do the same. Each element must leave the queue
+     * exactly once.
+     */
+    constexpr size_t numThreads{4};
+    constexpr size_t perThread{20000};
+    std::vector<TestElem> shared(numThreads * perThread);
+    TestQueue sq(numThreads);
+    std::atomic<size_t> popped{};
+    std::atomic<size_t> erased{};
+    std::vector<std::thread> threads;
+
+    for (size_t t{}; t < numThreads; ++t) {
+        threads.emplace_back([&, t]{
+            for (size_t i{}; i < perThread; ++i) {
+                TestElem &e{shared[t * perThread + i]};
+
+                e.v = static_cast<int>((i * 7919 + t * 104729) % 100003);
+                sq.push(&e);
+                if (i % 3 == 2 && sq.erase(&shared[t * perThread + i - 1])) {
+                    ++shared[t * perThread + i - 1].removed;
+                    ++erased;
+                }
+                if (i % 2 == 1) {
+                    if (auto p = sq.pop()) {
+                        ++(*p)->removed;
+                        ++popped;
+                    }
+                }
+            }
+        });
+    }
+    for (auto &th : threads)
+        th.join();
+
+    while (auto p = sq.pop()) {
+        ++(*p)->removed;
+        ++popped;
+    }
+
+    bool once{true};
+
+    for (const auto &e : shared)
+        once = once && e.removed == 1 && e.pos == TestQueue::npos;
+    std::cout << "\nconcurrent push/erase/pop:\n"
+              << "all removed once: " << once
+              << " total: " << popped + erased << '\n';
+
+    return 0;
+}
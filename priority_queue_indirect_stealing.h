@@ -0,0 +1,262 @@
+#ifndef PRIORITY_QUEUE_INDIRECT_STEALING_H_
+#define PRIORITY_QUEUE_INDIRECT_STEALING_H_
+/*
+ * Work-stealing per-thread indirect heaps
+ * https://github.com/lano1106/indirect_heap
+ *
+ * every thread owns a Base::IndirectPriorityQueue and normally only
+ * pushes and pops its own heap. When its heap is empty, pop() steals a
+ * batch of the highest priority elements of the most loaded heap and
+ * moves them to the thief heap. ie: timers of a saturated reactor thread
+ * are run by an idle one.
+ *
+ * The value recorded by setHeapIndex() packs the position of the element
+ * in its heap and the owner thread, like Base::MultiQueue does. A steal
+ * holds the locks of both heaps while it moves the elements, so erase()
+ * from any thread either finds the element in its old heap before the
+ * steal or in its new one after it.
+ *
+ * value_type must provide the following functions, found by ADL:
+ *
+ * void   setHeapIndex(value_type &, size_t);
+ * size_t getHeapIndex(const value_type &);
+ *
+ * erase() reads the recorded value while other threads may be moving the
+ * element, so it should be stored in a std::atomic accessed with relaxed
+ * ordering. npos is recorded in an element that leaves the queue.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "priority_queue_indirect.h"
+#include "priority_queue_indirect_multi.h"
+
+namespace Base {
+
+template <typename T,
+          typename Compare = std::less<T>,
+          typename Policy  = Base::default_policy>
+class WorkStealingQueue
+{
+public:
+    using value_compare = Compare;
+    using policy_type   = Policy;
+    using value_type    = T;
+    using size_type     = std::size_t;
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    /*
+     * one heap per thread. (at most 65536)
+     *
+     * a steal takes up to batch elements, but never more than half of
+     * the victim heap.
+     */
+    explicit WorkStealingQueue(size_type numThreads, size_type batch = 32,
+                               const Compare &comp   = Compare(),
+                               const Policy  &policy = Policy())
+    : m_numHeaps(std::clamp<size_type>(numThreads, 1, Elem::ShardMask + 1)),
+      m_heaps(std::make_unique<Heap[]>(m_numHeaps)),
+      m_batch(std::max<size_type>(batch, 1)),
+      m_comp{comp}
+    {
+        for (size_type i{}; i < m_numHeaps; ++i)
+            m_heaps[i].q = HeapQueue(m_comp, policy);
+    }
+
+    WorkStealingQueue(const WorkStealingQueue &) = delete;
+    WorkStealingQueue &operator=(const WorkStealingQueue &) = delete;
+
+    // may already be outdated when they return
+    size_type size(size_type thread) const noexcept
+    {
+        return m_heaps[thread].size.load(std::memory_order_relaxed);
+    }
+    size_type size() const noexcept
+    {
+        size_type n{};
+
+        for (size_type i{}; i < m_numHeaps; ++i)
+            n += size(i);
+        return n;
+    }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    /*
+     * thread currently owning v or npos if v is not in the queue
+     */
+    size_type owner(const value_type &v) const noexcept
+    {
+        const auto idx{static_cast<size_type>(getHeapIndex(v))};
+
+        return idx == npos ? npos : (idx & Elem::ShardMask);
+    }
+
+    void push(size_type thread, const value_type &v)
+    {
+        Heap &h{m_heaps[thread]};
+
+        h.lock.lock();
+        h.q.push({v, static_cast<std::uint32_t>(thread)});
+        h.size.store(h.q.size(), std::memory_order_relaxed);
+        h.lock.unlock();
+    }
+
+    /*
+     * remove the highest priority element of the thread heap. Steals
+     * from the most loaded heap when it is empty. Returns an empty
+     * optional if there is nothing to steal either.
+     *
+     * a victim can be drained by its owner before the thief takes its
+     * lock: the scan is retried as long as a heap is seen non-empty. An
+     * element moved by a concurrent steal can be missed by the scan, it
+     * is then popped by the thief.
+     */
+    std::optional<value_type> pop(size_type thread)
+    {
+        Heap &h{m_heaps[thread]};
+        HeapHelpers::backoff b;
+
+        for (;;) {
+            h.lock.lock();
+            if (!h.q.empty()) {
+                value_type v{h.q.top().value};
+
+                h.q.pop();
+                h.size.store(h.q.size(), std::memory_order_relaxed);
+                h.lock.unlock();
+                setHeapIndex(v, npos);
+                return v;
+            }
+            h.lock.unlock();
+            if (steal(thread))
+                continue;
+            if (empty())
+                return std::nullopt;
+            b.wait();
+        }
+    }
+
+    /*
+     * move a batch of the highest priority elements of the most loaded
+     * heap to the thief heap.
+     *
+     * returns the number of elements stolen.
+     */
+    size_type steal(size_type thief)
+    {
+        size_type victim{npos};
+        size_type victimSize{};
+
+        for (size_type i{}; i < m_numHeaps; ++i) {
+            const size_type n{size(i)};
+
+            if (i != thief && n > victimSize) {
+                victim     = i;
+                victimSize = n;
+            }
+        }
+        if (victim == npos)
+            return 0;
+
+        Heap &from{m_heaps[victim]};
+        Heap &to{m_heaps[thief]};
+
+        // fixed lock order between any 2 heaps
+        if (victim < thief) {
+            from.lock.lock();
+            to.lock.lock();
+        }
+        else {
+            to.lock.lock();
+            from.lock.lock();
+        }
+
+        const size_type count{std::min(m_batch, (from.q.size() + 1) / 2)};
+
+        for (size_type i{}; i < count; ++i) {
+            value_type v{from.q.top().value};
+
+            from.q.pop();
+            to.q.push({std::move(v), static_cast<std::uint32_t>(thief)});
+        }
+        // never let the moved elements appear in neither heap
+        to.size.store(to.q.size(), std::memory_order_relaxed);
+        from.size.store(from.q.size(), std::memory_order_relaxed);
+        from.lock.unlock();
+        to.lock.unlock();
+        return count;
+    }
+
+    /*
+     * remove v from the queue. Can be called from any thread.
+     *
+     * returns false if v is not in the queue, ie: it has been popped by
+     * another thread. v must have been pushed at least once.
+     */
+    bool erase(const value_type &v)
+    {
+        HeapHelpers::backoff b;
+
+        for (;;) {
+            const auto idx{static_cast<size_type>(getHeapIndex(v))};
+
+            if (idx == npos)
+                return false;
+
+            Heap &h{m_heaps[idx & Elem::ShardMask]};
+
+            h.lock.lock();
+
+            /*
+             * v may have been stolen, or popped and pushed again, since
+             * its position has been read.
+             */
+            const auto cur{static_cast<size_type>(getHeapIndex(v))};
+            const size_type pos{cur >> Elem::ShardBits};
+
+            if (cur == idx && pos < h.q.size() &&
+                h.q.container()[pos].value == v) {
+                h.q.erase(h.q.container()[pos]);
+                h.size.store(h.q.size(), std::memory_order_relaxed);
+                h.lock.unlock();
+
+                value_type out{v};
+
+                setHeapIndex(out, npos);
+                return true;
+            }
+            h.lock.unlock();
+            if (cur == npos)
+                return false;
+            b.wait();
+        }
+    }
+
+private:
+    using Elem        = HeapHelpers::shard_elem<T>;
+    using ElemCompare = HeapHelpers::shard_elem_compare<Compare>;
+    using HeapQueue   = IndirectPriorityQueue<Elem, ElemCompare,
+                                              std::vector<Elem>, Policy>;
+
+    struct alignas(64) Heap
+    {
+        HeapHelpers::spinlock  lock;
+        std::atomic<size_type> size{0};
+        HeapQueue              q;
+    };
+
+    const size_type         m_numHeaps;
+    std::unique_ptr<Heap[]> m_heaps;
+    const size_type         m_batch;
+    ElemCompare             m_comp;
+};
+}
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * work-stealing indirect queue test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g -pthread priority_queue_indirect_stealing_test.cpp
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "priority_queue_indirect_stealing.h"
+
+struct TestElem
+{
+    int                 v;
+    std::atomic<size_t> pos{Base::WorkStealingQueue<TestElem *>::npos};
+    std::atomic<int>    removed{};
+};
+
+/*
+ * provide functions required by Base::WorkStealingQueue
+ */
+inline void setHeapIndex(TestElem *e, size_t idx)
+{
+    e->pos.store(idx, std::memory_order_relaxed);
+}
+
+inline size_t getHeapIndex(const TestElem *e)
+{
+    return e->pos.load(std::memory_order_relaxed);
+}
+
+struct TestElemCmp
+{
+    bool operator()(const TestElem *lhs, const TestElem *rhs) const
+    {
+        return lhs->v < rhs->v;
+    }
+};
+
+using TestQueue = Base::WorkStealingQueue<TestElem *, TestElemCmp>;
+
+int main()
+{
+    const char *str{"EASYQUESTION"};
+    std::vector<TestElem> elems(12);
+    TestQueue q(2, 4);
+
+    for (size_t i{}; i < elems.size(); ++i) {
+        elems[i].v = str[i];
+        q.push(0, &elems[i]);
+    }
+    std::cout << "thread 0 insert(EASYQUESTION):\n";
+    std::cout << "sizes: " << q.size(0) << ' ' << q.size(1) << '\n';
+
+    std::cout << "\nthread 1 steal:\n";
+    std::cout << "stolen: " << q.steal(1) << '\n';
+    std::cout << "sizes: " << q.size(0) << ' ' << q.size(1) << '\n';
+    std::cout << "owner(Y): " << q.owner(&elems[3])
+              << " owner(A): " << q.owner(&elems[1]) << '\n';
+
+    std::cout << "\nerase(Y), erase(A):\n";
+    std::cout << q.erase(&elems[3]) << ' ' << q.erase(&elems[1]) << '\n';
+    std::cout << "sizes: " << q.size(0) << ' ' << q.size(1) << '\n';
+
+    std::cout << "\nthread 1 pop all:\n";
+    while (auto e = q.pop(1))
+        std::cout << static_cast<char>((*e)->v) << ' ';
+    std::cout << '\n';
+
+    /*
+     * thread 0 is the only producer. The other threads pop, stealing from
+     * thread 0, and erase elements that may be in any heap. Each element
+     * must leave the queue exactly once.
+     */
+    constexpr size_t numThreads{4};
+    constexpr size_t total{60000};
+    std::vector<TestElem> shared(total);
+    TestQueue sq(numThreads, 16);
+    std::atomic<bool> done{false};
+    std::atomic<size_t> removed{};
+    std::vector<std::thread> threads;
+
+    threads.emplace_back([&]{
+        for (size_t i{}; i < total; ++i) {
+            shared[i].v = static_cast<int>((i * 7919) % 100003);
+            sq.push(0, &shared[i]);
+            if (i % 4 == 3) {
+                if (auto p = sq.pop(0)) {
+                    ++(*p)->removed;
+                    ++removed;
+                }
+            }
+        }
+        done = true;
+    });
+    for (size_t t{1}; t < numThreads; ++t) {
+        threads.emplace_back([&, t]{
+            size_t i{t};
+
+            while (!done || !sq.empty()) {
+                if (auto p = sq.pop(t)) {
+                    ++(*p)->removed;
+                    ++removed;
+                }
+                i = (i * 48271) % total;
+                if (sq.erase(&shared[i])) {
+                    ++shared[i].removed;
+                    ++removed;
+                }
+            }
+        });
+    }
+    for (auto &th : threads)
+        th.join();
+
+    bool once{true};
+
+    for (const auto &e : shared)
+        once = once && e.removed == 1 && e.pos == TestQueue::npos;
+    std::cout << "\nwork stealing push/erase/pop:\n"
+              << "all removed once: " << once
+              << " total: " << removed << '\n';
+
+    /*
+     * the consumers stop at their first empty pop: the victims drained
+     * under them must not stop them before the queue is empty
+     */
+    std::vector<TestElem> drained(total);
+    TestQueue dq(numThreads, 16);
+    std::atomic<size_t> popped{};
+
+    for (size_t i{}; i < total; ++i) {
+        drained[i].v = static_cast<int>((i * 7919) % 100003);
+        dq.push(i % 2, &drained[i]);
+    }
+    threads.clear();
+    for (size_t t{}; t < numThreads; ++t) {
+        threads.emplace_back([&, t]{
+            while (dq.pop(t))
+                ++popped;
+        });
+    }
+    for (auto &th : threads)
+        th.join();
+    std::cout << "\nwork stealing pop until empty:\n"
+              << "popped: " << popped << " left: " << dq.size() << '\n';
+
+    return 0;
+}
@@ -0,0 +1,428 @@
+/*
+ * indirect priority queue test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g priority_queue_indirect_test.cpp
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include "priority_queue_indirect.h"
+
+struct TestElem
+{
+    char   v;
+    size_t pos{};
+};
+
+/*
+ * provide functions required by Base::IndirectPriorityQueue
+ */
+inline void setHeapIndex(TestElem *e, size_t idx)
+{
+    e->pos = idx;
+}
+
+inline size_t getHeapIndex(const TestElem *e)
+{
+    return e->pos;
+}
+
+struct TestElemCmp
+{
+    bool operator()(const TestElem *lhs, const TestElem *rhs) const
+    {
+        return lhs->v < rhs->v;
+    }
+};
+
+using TestQueue = Base::IndirectPriorityQueue<TestElem *, TestElemCmp>;
+
+/*
+ * intrusive hooks: a 32 bits index, and an element in 2 heaps at once
+ */
+struct HookElem : Base::heap_hook<uint32_t>
+{
+    char v;
+};
+
+/*
+ * 16 bits index filled up to its maximum heap size
+ */
+struct ShortHookElem : Base::heap_hook<uint16_t>
+{
+    uint16_t v;
+};
+
+struct PrioTag {};
+struct DeadlineTag {};
+
+struct DualElem : Base::heap_hook<uint32_t, PrioTag>,
+                  Base::heap_hook<uint16_t, DeadlineTag>
+{
+    char prio;
+    char deadline;
+};
+
+struct HookCmp
+{
+    bool operator()(const HookElem *lhs, const HookElem *rhs) const
+    {
+        return lhs->v < rhs->v;
+    }
+    bool operator()(const DualElem *lhs, const DualElem *rhs) const
+    {
+        return lhs->prio < rhs->prio;
+    }
+};
+
+struct ShortHookCmp
+{
+    bool operator()(const ShortHookElem *lhs, const ShortHookElem *rhs) const
+    {
+        return lhs->v < rhs->v;
+    }
+};
+
+struct DeadlineCmp
+{
+    bool operator()(const DualElem *lhs, const DualElem *rhs) const
+    {
+        return lhs->deadline > rhs->deadline;
+    }
+};
+
+/*
+ * equal priorities popped in insertion order with Base::fifo_compare
+ */
+struct FifoElem
+{
+    char          prio;
+    char          name;
+    size_t        pos{};
+    std::uint64_t seq{};
+};
+
+inline void setHeapIndex(FifoElem *e, size_t idx)
+{
+    e->pos = idx;
+}
+
+inline size_t getHeapIndex(const FifoElem *e)
+{
+    return e->pos;
+}
+
+inline void setHeapSequence(FifoElem *e, std::uint64_t seq)
+{
+    e->seq = seq;
+}
+
+inline std::uint64_t getHeapSequence(const FifoElem *e)
+{
+    return e->seq;
+}
+
+struct FifoElemCmp
+{
+    bool operator()(const FifoElem *lhs, const FifoElem *rhs) const
+    {
+        return lhs->prio < rhs->prio;
+    }
+};
+
+template <typename Policy>
+void popFifo(const char *label)
+{
+    const char *prios{"AABABBAAABAB"};
+    std::vector<FifoElem> fifoElems;
+    Base::IndirectPriorityQueue<FifoElem *, Base::fifo_compare<FifoElemCmp>,
+                                std::vector<FifoElem *>, Policy> fifoQ;
+
+    for (size_t i{}; prios[i]; ++i)
+        fifoElems.push_back({prios[i], static_cast<char>('a' + i)});
+    for (auto &e : fifoElems)
+        fifoQ.push(&e);
+    std::cout << "\npop all (FIFO ties, " << label << "):\n";
+    while (!fifoQ.empty()) {
+        std::cout << fifoQ.top()->prio << fifoQ.top()->name << ' ';
+        fifoQ.pop();
+    }
+    std::cout << '\n';
+
+    std::vector<FifoElem *> ptrs;
+    for (auto &e : fifoElems)
+        ptrs.push_back(&e);
+    decltype(fifoQ) bulkQ(ptrs.begin(), ptrs.end());
+    std::cout << "bulk construction:\n";
+    while (!bulkQ.empty()) {
+        std::cout << bulkQ.top()->prio << bulkQ.top()->name << ' ';
+        bulkQ.pop();
+    }
+    std::cout << '\n';
+}
+
+/*
+ * the elements pushed after a merge come out after the merged ones
+ */
+void mergeFifo()
+{
+    using FifoQueue = Base::IndirectPriorityQueue<FifoElem *,
+                                                  Base::fifo_compare<FifoElemCmp> >;
+    std::vector<FifoElem> fifoElems;
+    FifoQueue q1;
+    FifoQueue q2;
+
+    for (char name : {'a', 'b', 'c', 'd', 'e', 'f'})
+        fifoElems.push_back({'A', name});
+    q1.push(&fifoElems[0]);
+    for (size_t i{1}; i < 4; ++i)
+        q2.push(&fifoElems[i]);
+    q1.merge(std::move(q2));
+    q1.push(&fifoElems[4]);
+    q1.push(&fifoElems[5]);
+
+    /*
+     * a rejected try_replace_top() or push_pop() keeps the stamp of its
+     * element
+     */
+    FifoElem x{'B', 'x', 0, 77};
+    FifoElem y{'B', 'y', 0, 42};
+    FifoElem z{'A', 'z', 0, 42};
+    FifoElem *v{&y};
+
+    std::cout << "\npush_pop(Bx): " << q1.push_pop(&x)->name
+              << " x seq: " << x.seq << '\n';
+    std::cout << "try_replace_top(By): " << q1.try_replace_top(v)
+              << " y seq: " << y.seq << '\n';
+    v = &z;
+    std::cout << "try_replace_top(Az): " << q1.try_replace_top(v)
+              << " replaced: " << v->name << " z seq: " << z.seq << '\n';
+    std::cout << "merge(a into bcd), push(ef), replace(z) (FIFO ties):\n";
+    while (!q1.empty()) {
+        std::cout << q1.top()->name << q1.top()->seq << ' ';
+        q1.pop();
+    }
+    std::cout << '\n';
+}
+
+/*
+ * the elements pushed after a restore come out after the restored ones
+ */
+void restoreFifo()
+{
+    using FifoQueue = Base::IndirectPriorityQueue<FifoElem *,
+                                                  Base::fifo_compare<FifoElemCmp> >;
+    std::vector<FifoElem> fifoElems;
+    FifoQueue q;
+    FifoQueue restoredQ;
+
+    for (char name : {'a', 'b', 'c'})
+        fifoElems.push_back({'A', name});
+    q.push(&fifoElems[0]);
+    q.push(&fifoElems[1]);
+
+    const std::vector<FifoElem *> snapshot(q.container().begin(),
+                                           q.container().end());
+    restoredQ.restore(snapshot.begin(), snapshot.end());
+    restoredQ.push(&fifoElems[2]);
+    std::cout << "\nrestore(ab), push(c) (FIFO ties):\n";
+    while (!restoredQ.empty()) {
+        std::cout << restoredQ.top()->name << restoredQ.top()->seq << ' ';
+        restoredQ.pop();
+    }
+    std::cout << '\n';
+}
+
+void printQueue(const TestQueue &q)
+{
+    for (const auto *e : q.container())
+        std::cout << e->v << ' ';
+    std::cout << '\n';
+    for (const auto *e : q.container())
+        std::cout << e->pos << ' ';
+    std::cout << '\n';
+}
+
+int main()
+{
+    std::vector<TestElem> elems{ {'E'}, {'A'}, {'S'}, {'Y'},
+                                 {'Q'}, {'U'}, {'E'}, {'S'}, {'T'}, {'I'}, {'O'}, {'N'} };
+    TestQueue q;
+
+    q.reserve(elems.size());
+    for (auto &e : elems)
+        q.push(&e);
+    std::cout << "insert(EASYQUESTION):\n";
+    printQueue(q);
+
+    std::cout << "\nerase(U):\n";
+    q.erase(&elems[5]);
+    printQueue(q);
+
+    std::cout << "\nerase(Y):\n";
+    q.erase(&elems[3]);
+    printQueue(q);
+
+    std::cout << "\nupdate(A->Z):\n";
+    elems[1].v = 'Z';
+    q.update(&elems[1]);
+    printQueue(q);
+
+    std::cout << "\nupdate(Z->B):\n";
+    elems[1].v = 'B';
+    q.update(&elems[1]);
+    printQueue(q);
+
+    std::cout << "\npop all:\n";
+    while (!q.empty()) {
+        std::cout << q.top()->v << ' ';
+        q.pop();
+    }
+    std::cout << '\n';
+
+    std::vector<TestElem *> ptrs;
+    for (auto &e : elems)
+        ptrs.push_back(&e);
+    TestQueue bulkQ(ptrs.begin(), ptrs.end());
+    std::cout << "\nbulk construction:\n";
+    printQueue(bulkQ);
+
+    Base::heap_counters counters;
+    Base::IndirectPriorityQueue<TestElem *, TestElemCmp,
+                                std::vector<TestElem *>,
+                                Base::instrumented_policy<Base::heap_counters> >
+        countedQ(ptrs.begin(), ptrs.end(), {},
+                 Base::instrumented_policy<Base::heap_counters>{counters});
+    std::cout << "instrumented bulk construction, ops: " << counters.ops
+              << " index updates: " << counters.index_updates << '\n';
+
+    Base::IndirectPriorityQueue<TestElem *, TestElemCmp,
+                                std::vector<TestElem *>,
+                                Base::bottom_up_policy> bottomUpQ(ptrs.begin(), ptrs.end());
+    std::cout << "\npop all (bottom-up policy):\n";
+    while (!bottomUpQ.empty()) {
+        std::cout << bottomUpQ.top()->v << ' ';
+        bottomUpQ.pop();
+    }
+    std::cout << '\n';
+
+    popFifo<Base::top_down_policy>("top-down policy");
+    popFifo<Base::bottom_up_policy>("bottom-up policy");
+    mergeFifo();
+    restoreFifo();
+
+    TestQueue smallQ(ptrs.begin(), ptrs.begin() + 4);
+    TestQueue largeQ(ptrs.begin() + 4, ptrs.end());
+    std::cout << "\nmerge(EASY into QUESTION):\n";
+    smallQ.merge(std::move(largeQ));
+    printQueue(smallQ);
+    std::cout << "merged from size: " << largeQ.size() << '\n';
+
+    /*
+     * integer ids whose positions are recorded in a handle table
+     */
+    std::string_view      idStr{"EASYQUESTION"};
+    std::vector<char>     idKeys(idStr.begin(), idStr.end());
+    std::vector<uint32_t> idPos(idKeys.size());
+    using IdPolicy = Base::handle_table_policy<>;
+    Base::IndirectPriorityQueue<uint32_t, Base::id_compare<char>,
+                                std::vector<uint32_t>, IdPolicy>
+        idQ(Base::id_compare<char>{idKeys.data()}, IdPolicy{idPos.data()});
+
+    for (uint32_t id{}; id < idKeys.size(); ++id)
+        idQ.push(id);
+    std::cout << "\nhandle table erase(Y), update(A->Z):\n";
+    idQ.erase(3);
+    idKeys[1] = 'Z';
+    idQ.update(1);
+    for (const auto id : idQ.container())
+        std::cout << idKeys[id] << ' ';
+    std::cout << '\n';
+    for (const auto id : idQ.container())
+        std::cout << idPos[id] << ' ';
+    std::cout << '\n';
+
+    using KeyedElem = Base::keyed_ptr<char, TestElem>;
+    Base::IndirectPriorityQueue<KeyedElem, Base::key_compare<> > keyedQ;
+
+    for (auto &e : elems)
+        keyedQ.push({e.v, &e});
+    std::cout << "\nkeyed update_key(B->Z):\n";
+    elems[1].v = 'Z';
+    keyedQ.update_key({'B', &elems[1]}, 'Z');
+    for (const auto &e : keyedQ.container())
+        std::cout << e.key << ' ';
+    std::cout << '\n';
+    for (const auto &e : keyedQ.container())
+        std::cout << e.ptr->pos << ' ';
+    std::cout << '\n';
+
+    const char *str{"EASYQUESTION"};
+    std::vector<HookElem> hookElems(elems.size());
+    Base::IndirectPriorityQueue<HookElem *, HookCmp> hookQ;
+
+    for (size_t i{}; i < elems.size(); ++i) {
+        hookElems[i].v = str[i];
+        hookQ.push(&hookElems[i]);
+    }
+    std::cout << "\nheap_hook<uint32_t> (" << sizeof(HookElem) << " bytes), erase(Y):\n";
+    hookQ.erase(&hookElems[3]);
+    clearHeapIndex(&hookElems[3]);
+    for (const auto *e : hookQ.container())
+        std::cout << e->v << ' ';
+    std::cout << '\n';
+    for (const auto *e : hookQ.container())
+        std::cout << e->heapIndex() << ' ';
+    std::cout << "\nY in heap: " << hookElems[3].inHeap() << '\n';
+
+    using PrioHook     = Base::heap_hook<uint32_t, PrioTag>;
+    using DeadlineHook = Base::heap_hook<uint16_t, DeadlineTag>;
+    std::vector<DualElem> dualElems(elems.size());
+    Base::IndirectPriorityQueue<Base::hook_ptr<DualElem, PrioTag>, HookCmp> prioQ;
+    Base::IndirectPriorityQueue<Base::hook_ptr<DualElem, DeadlineTag>, DeadlineCmp> deadlineQ;
+
+    for (size_t i{}; i < elems.size(); ++i) {
+        dualElems[i].prio     = str[i];
+        dualElems[i].deadline = str[elems.size() - 1 - i];
+        prioQ.push(&dualElems[i]);
+        deadlineQ.push(&dualElems[i]);
+    }
+    std::cout << "\n2 hooks (" << sizeof(DualElem) << " bytes), erase(Y) from both:\n";
+    prioQ.erase(&dualElems[3]);
+    deadlineQ.erase(&dualElems[3]);
+    for (const auto &e : prioQ.container())
+        std::cout << e->prio << ' ';
+    std::cout << '\n';
+    for (const auto &e : prioQ.container())
+        std::cout << static_cast<const PrioHook &>(*e).heapIndex() << ' ';
+    std::cout << '\n';
+    for (const auto &e : deadlineQ.container())
+        std::cout << e->deadline << ' ';
+    std::cout << '\n';
+    for (const auto &e : deadlineQ.container())
+        std::cout << static_cast<const DeadlineHook &>(*e).heapIndex() << ' ';
+    std::cout << '\n';
+
+    using ShortHook = Base::heap_hook<uint16_t>;
+    std::vector<ShortHookElem> shortElems(ShortHook::max_heap_size);
+    Base::IndirectPriorityQueue<ShortHookElem *, ShortHookCmp> shortQ;
+    size_t inHeap{};
+
+    for (size_t i{}; i < shortElems.size(); ++i) {
+        shortElems[i].v = static_cast<uint16_t>(i * 7919);
+        shortQ.push(&shortElems[i]);
+    }
+    for (const auto &e : shortElems)
+        inHeap += e.inHeap();
+    std::cout << "\nheap_hook<uint16_t> max_heap_size " << ShortHook::max_heap_size
+              << ", in heap: " << inHeap << '\n';
+    shortQ.erase(&shortElems[0]);
+    clearHeapIndex(&shortElems[0]);
+    std::cout << "erased element in heap: " << shortElems[0].inHeap() << '\n';
+
+    return 0;
+}
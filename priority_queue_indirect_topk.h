@@ -0,0 +1,150 @@
+#ifndef PRIORITY_QUEUE_INDIRECT_TOPK_H_
+#define PRIORITY_QUEUE_INDIRECT_TOPK_H_
+/*
+ * Bounded top-K indirect queue
+ * https://github.com/lano1106/indirect_heap
+ *
+ * keeps the K highest priority elements offered to it, ie: the best N
+ * quotes of a book view. The kept elements are in an indirect heap with
+ * the worst of them on top:
+ *
+ * - offer() of an element better than the worst kept one replaces it with
+ *   a single sift (see Base::try_replace_top()) and passes the evicted
+ *   element to the eviction callback.
+ * - erase() removes a withdrawn element in O(log n) through the position
+ *   stored by setHeapIndex().
+ *
+ * value_type must provide the following functions, found by ADL:
+ *
+ * void   setHeapIndex(value_type &, size_t);
+ * size_t getHeapIndex(const value_type &);
+ *
+ * OnEvict is called with every element evicted by an offer(), as an
+ * rvalue. Rejected offers are only reported by the offer() result.
+ *
+ * Policy is the heap policy passed to the heap algorithms.
+ * (see Base::heap_policy)
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "priority_queue_indirect.h"
+
+namespace Base {
+
+namespace HeapHelpers {
+/*
+ * puts the lowest priority element of Compare on top of the heap
+ */
+template <typename Compare>
+struct reverse_compare
+{
+    [[no_unique_address]] Compare comp;
+
+    template <typename Lhs, typename Rhs>
+    constexpr bool operator()(const Lhs &lhs, const Rhs &rhs) const
+    {
+        return comp(rhs, lhs);
+    }
+};
+}
+
+/*
+ * default eviction callback
+ */
+struct discard_evicted
+{
+    template <typename T>
+    constexpr void operator()(T &&) const noexcept {}
+};
+
+template <typename T,
+          typename Compare   = std::less<T>,
+          typename OnEvict   = Base::discard_evicted,
+          typename Container = std::vector<T>,
+          typename Policy    = Base::default_policy>
+class TopKQueue
+{
+public:
+    using container_type  = Container;
+    using value_compare   = Compare;
+    using policy_type     = Policy;
+    using value_type      = typename Container::value_type;
+    using size_type       = typename Container::size_type;
+    using const_reference = typename Container::const_reference;
+
+    /*
+     * keep at most k elements. k must be at least 1.
+     */
+    explicit TopKQueue(size_type k,
+                       const Compare &comp   = Compare(),
+                       const OnEvict &evict  = OnEvict(),
+                       const Policy  &policy = Policy())
+    : m_q(HeapHelpers::reverse_compare<Compare>{comp}, policy),
+      m_evict(evict), m_k(k)
+    {
+        assert(k > 0);
+        m_q.reserve(k);
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return m_q.empty(); }
+    size_type size() const noexcept { return m_q.size(); }
+    size_type max_size() const noexcept { return m_k; }
+    bool full() const noexcept { return m_q.size() == m_k; }
+    void clear() noexcept { m_q.clear(); }
+
+    /*
+     * lowest priority element kept, the next one to be evicted.
+     */
+    const_reference worst() const { return m_q.top(); }
+
+    /*
+     * keep v if the queue is not full or v has a higher priority than the
+     * worst element kept, which is then evicted. Returns false when v is
+     * rejected. Ties are rejected, the elements kept first stay.
+     */
+    bool offer(value_type v)
+    {
+        if (!full()) {
+            m_q.push(std::move(v));
+            return true;
+        }
+        // the comparison with the worst is counted by the replace operation
+        if (!m_q.try_replace_top(v))
+            return false;
+        m_evict(std::move(v));
+        return true;
+    }
+
+    /*
+     * remove v from the queue. The eviction callback is not called.
+     *
+     * v must be in the queue.
+     */
+    void erase(const value_type &v) { m_q.erase(v); }
+
+    /*
+     * restore the heap condition after the priority of v has been
+     * modified.
+     *
+     * v must be in the queue.
+     */
+    void update(const value_type &v) { m_q.update(v); }
+
+    // heap of the kept elements, the worst on top
+    const container_type &container() const noexcept { return m_q.container(); }
+
+private:
+    using Heap = IndirectPriorityQueue<T, HeapHelpers::reverse_compare<Compare>,
+                                       Container, Policy>;
+
+    Heap      m_q;
+    [[no_unique_address]] OnEvict m_evict;
+    size_type m_k;
+};
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * bounded top-K indirect queue test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g priority_queue_indirect_topk_test.cpp
+ */
+
+#include <iostream>
+#include <vector>
+#include "priority_queue_indirect_topk.h"
+
+struct TestElem
+{
+    char   v;
+    size_t pos{};
+};
+
+/*
+ * provide functions required by Base::TopKQueue
+ */
+inline void setHeapIndex(TestElem *e, size_t idx)
+{
+    e->pos = idx;
+}
+
+inline size_t getHeapIndex(const TestElem *e)
+{
+    return e->pos;
+}
+
+struct TestElemCmp
+{
+    bool operator()(const TestElem *lhs, const TestElem *rhs) const
+    {
+        return lhs->v < rhs->v;
+    }
+};
+
+struct PrintEvicted
+{
+    void operator()(TestElem *e) const
+    {
+        std::cout << "evicted " << e->v << '\n';
+    }
+};
+
+using TestQueue = Base::TopKQueue<TestElem *, TestElemCmp, PrintEvicted>;
+
+void printQueue(const TestQueue &q)
+{
+    for (const auto *e : q.container())
+        std::cout << e->v << ' ';
+    std::cout << '\n';
+    for (const auto *e : q.container())
+        std::cout << e->pos << ' ';
+    std::cout << '\n';
+}
+
+int main()
+{
+    std::vector<TestElem> elems{ {'E'}, {'A'}, {'S'}, {'Y'},
+                                 {'Q'}, {'U'}, {'E'}, {'S'}, {'T'}, {'I'}, {'O'}, {'N'} };
+    TestQueue q(4);
+
+    std::cout << "top 4 offer(EASYQUESTION):\n";
+    for (auto &e : elems) {
+        if (!q.offer(&e))
+            std::cout << "rejected " << e.v << '\n';
+    }
+    printQueue(q);
+
+    std::cout << "\nerase(U):\n";
+    q.erase(&elems[5]);
+    printQueue(q);
+
+    std::cout << "\noffer(N):\n";
+    q.offer(&elems[11]);
+    printQueue(q);
+
+    std::cout << "\nupdate(Y->B), offer(O):\n";
+    elems[3].v = 'B';
+    q.update(&elems[3]);
+    q.offer(&elems[10]);
+    printQueue(q);
+
+    std::cout << "\nworst: " << q.worst()->v << " size: " << q.size()
+              << " full: " << q.full() << '\n';
+
+    /*
+     * an offer to a full queue is a single sift, including the comparison
+     * with the worst kept element
+     */
+    Base::heap_counters counters;
+    Base::TopKQueue<TestElem *, TestElemCmp, Base::discard_evicted,
+                    std::vector<TestElem *>,
+                    Base::instrumented_policy<Base::heap_counters> >
+        countedQ(4, {}, {}, Base::instrumented_policy<Base::heap_counters>{counters});
+
+    for (auto &e : elems)
+        countedQ.offer(&e);
+    std::cout << "\ninstrumented offer(EASYQUESTION):\n"
+              << "ops: " << counters.ops << " compares: " << counters.compares
+              << " index updates: " << counters.index_updates << '\n';
+
+    return 0;
+}
@@ -0,0 +1,274 @@
+#ifndef TIMER_QUEUE_INDIRECT_H_
+#define TIMER_QUEUE_INDIRECT_H_
+/*
+ * Timer queue: timing wheel in front of an indirect heap
+ * https://github.com/lano1106/indirect_heap
+ *
+ * G. Varghese, T. Lauck.
+ * Hashed and Hierarchical Timing Wheels (1987)
+ *
+ * Timers whose deadline falls within the next Slots ticks are linked in
+ * the wheel slot of their deadline: arming and cancelling them is O(1).
+ * The other ones are kept in an indirect heap (see
+ * Base::IndirectPriorityQueue) and cascade into the wheel as it turns,
+ * once their deadline falls within its range. Timers that are cancelled
+ * before then, like connection idle timers, never leave the heap.
+ *
+ * So size the wheel and pick the tick so that the common timeouts are
+ * within Slots ticks. ie: 4096 slots of 10ms cover 40s.
+ *
+ * Timers derive from Base::timer_hook:
+ *
+ * struct Conn : Base::timer_hook { ... };
+ * Base::TimerQueue<Conn> timers;
+ *
+ * timers.arm(conn, timers.now() + idleTicks);
+ * timers.cancel(conn);
+ * timers.advance(tick, [](Conn &c){ ... });
+ *
+ * The queue does not own the timers. A timer must be cancelled or expired
+ * before it is destroyed.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "priority_queue_indirect.h"
+
+namespace Base {
+
+template <typename T, std::size_t Slots>
+class TimerQueue;
+
+namespace HeapHelpers {
+struct timer_tag {};
+
+/*
+ * doubly linked list node of the wheel slots. Each slot is a circular
+ * list with a sentinel node.
+ */
+struct timer_link
+{
+    timer_link *next{};
+    timer_link *prev{};
+};
+}
+
+/*
+ * timer hook
+ *
+ * holds the deadline of a timer and either its wheel slot links or its
+ * heap position.
+ */
+class timer_hook : private HeapHelpers::timer_link,
+                   public heap_hook<std::uint32_t, HeapHelpers::timer_tag>
+{
+public:
+    using tick_type = std::uint64_t;
+
+    tick_type deadline() const noexcept { return m_deadline; }
+    bool armed() const noexcept { return prev || inHeap(); }
+
+private:
+    template <typename T, std::size_t Slots>
+    friend class TimerQueue;
+
+    tick_type m_deadline{};
+};
+
+/*
+ * Slots must be a power of 2.
+ */
+template <typename T, std::size_t Slots = 4096>
+class TimerQueue
+{
+public:
+    static_assert(Slots > 0 && (Slots & (Slots - 1)) == 0,
+                  "the number of slots must be a power of 2");
+
+    using timer_type = T;
+    using tick_type  = timer_hook::tick_type;
+    using size_type  = std::size_t;
+
+    explicit TimerQueue(tick_type now = 0) : m_next(now)
+    {
+        for (auto &s : m_slots)
+            s.next = s.prev = &s;
+    }
+
+    TimerQueue(const TimerQueue &) = delete;
+    TimerQueue &operator=(const TimerQueue &) = delete;
+
+    /*
+     * next tick to expire. Deadlines before it expire at the next
+     * advance().
+     */
+    tick_type now() const noexcept { return m_next; }
+
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+    size_type size() const noexcept { return m_wheelSize + m_heap.size(); }
+
+    // timers in the heap
+    size_type far_size() const noexcept { return m_heap.size(); }
+
+    /*
+     * arm t to expire at deadline. An armed timer is re-armed.
+     */
+    void arm(T &t, tick_type deadline)
+    {
+        timer_hook &h{t};
+
+        if (h.armed())
+            cancel(t);
+        h.m_deadline = std::max(deadline, m_next);
+        if (h.m_deadline - m_next < Slots)
+            link(h);
+        else
+            m_heap.push(&h);
+    }
+
+    /*
+     * disarm t. Returns false if it was not armed.
+     */
+    bool cancel(T &t)
+    {
+        timer_hook &h{t};
+
+        if (h.prev) {
+            unlink(h);
+            return true;
+        }
+        if (h.inHeap()) {
+            m_heap.erase(&h);
+            clearHeapIndex(&h);
+            return true;
+        }
+        return false;
+    }
+
+    /*
+     * expire the timers whose deadline is at most now, in deadline
+     * order, calling expire(T &) for each of them. The timers are
+     * disarmed before the call, which can arm or cancel any timer.
+     * Returns the number of expired timers.
+     *
+     * Empty wheel revolutions are skipped, so the cost is proportional to
+     * the ticks elapsed up to Slots and to the expired timers.
+     */
+    template <typename Expire>
+    size_type advance(tick_type now, Expire &&expire)
+    {
+        size_type expired{};
+
+        while (m_next <= now) {
+            if (m_wheelSize == 0) {
+                // jump to the first tick whose slots may hold a heap timer
+                tick_type skipTo{now + 1};
+
+                if (!m_heap.empty())
+                    skipTo = std::min(skipTo, m_heap.top()->m_deadline - (Slots - 1));
+                m_next = std::max(m_next, skipTo);
+                cascade();
+                continue;
+            }
+
+            /*
+             * detach the slot before turning the wheel: the slot of this
+             * tick becomes the one of the last tick of the wheel range.
+             */
+            HeapHelpers::timer_link due;
+            HeapHelpers::timer_link &slot{m_slots[m_next & (Slots - 1)]};
+
+            if (slot.next != &slot) {
+                due.next       = slot.next;
+                due.prev       = slot.prev;
+                due.next->prev = &due;
+                due.prev->next = &due;
+                slot.next = slot.prev = &slot;
+            }
+            else {
+                due.next = due.prev = &due;
+            }
+            ++m_next;
+            cascade();
+            while (due.next != &due) {
+                timer_hook &h{*static_cast<timer_hook *>(due.next)};
+
+                unlink(h);
+                ++expired;
+                expire(static_cast<T &>(h));
+            }
+        }
+        return expired;
+    }
+
+    /*
+     * deadline of the next timer to expire, ie: to compute a poll
+     * timeout. Scans the wheel up to its first armed slot.
+     */
+    std::optional<tick_type> next_deadline() const noexcept
+    {
+        if (m_wheelSize) {
+            for (tick_type t{m_next};; ++t) {
+                const HeapHelpers::timer_link &slot{m_slots[t & (Slots - 1)]};
+
+                if (slot.next != &slot)
+                    return t;
+            }
+        }
+        if (!m_heap.empty())
+            return m_heap.top()->m_deadline;
+        return std::nullopt;
+    }
+
+private:
+    struct DeadlineCmp
+    {
+        bool operator()(const timer_hook *lhs, const timer_hook *rhs) const noexcept
+        {
+            return lhs->m_deadline > rhs->m_deadline;
+        }
+    };
+
+    void link(timer_hook &h) noexcept
+    {
+        HeapHelpers::timer_link &slot{m_slots[h.m_deadline & (Slots - 1)]};
+
+        h.next           = &slot;
+        h.prev           = slot.prev;
+        slot.prev->next  = &h;
+        slot.prev        = &h;
+        ++m_wheelSize;
+    }
+
+    void unlink(timer_hook &h) noexcept
+    {
+        h.prev->next = h.next;
+        h.next->prev = h.prev;
+        h.next = h.prev = nullptr;
+        --m_wheelSize;
+    }
+
+    // move the heap timers that entered the wheel range to their slot
+    void cascade()
+    {
+        while (!m_heap.empty() && m_heap.top()->m_deadline - m_next < Slots) {
+            timer_hook *h{m_heap.top()};
+
+            m_heap.pop();
+            clearHeapIndex(h);
+            link(*h);
+        }
+    }
+
+    HeapHelpers::timer_link m_slots[Slots];
+    IndirectPriorityQueue<timer_hook *, DeadlineCmp> m_heap;
+    size_type m_wheelSize{};
+    tick_type m_next;
+};
+}
+
+#endif
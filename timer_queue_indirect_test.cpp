@@ -0,0 +1,71 @@
+/*
+ * timer queue test
+ * https://github.com/lano1106/indirect_heap
+ *
+ * to compile:
+ * g++ -std=c++26 -g timer_queue_indirect_test.cpp
+ */
+
+#include <iostream>
+#include <vector>
+#include "timer_queue_indirect.h"
+
+struct TestTimer : Base::timer_hook
+{
+    char name;
+
+    explicit TestTimer(char n) : name(n) {}
+};
+
+// 8 ticks wheel to exercise the cascade from the heap
+using TestQueue = Base::TimerQueue<TestTimer, 8>;
+
+int main()
+{
+    std::vector<TestTimer> timers{ TestTimer{'A'}, TestTimer{'B'}, TestTimer{'C'},
+                                   TestTimer{'D'}, TestTimer{'E'}, TestTimer{'F'} };
+    TestQueue q;
+    auto print{[](TestTimer &t){
+        std::cout << t.name << '@' << t.deadline() << ' ';
+    }};
+
+    q.arm(timers[0], 3);
+    q.arm(timers[1], 20);
+    q.arm(timers[2], 5);
+    q.arm(timers[3], 100);
+    q.arm(timers[4], 7);
+    q.arm(timers[5], 12);
+    std::cout << "arm A@3 B@20 C@5 D@100 E@7 F@12:\n"
+              << "size: " << q.size() << " far: " << q.far_size()
+              << " next: " << *q.next_deadline() << '\n';
+
+    std::cout << "\ncancel(C), cancel(D), re-arm E@2:\n";
+    std::cout << q.cancel(timers[2]) << ' ' << q.cancel(timers[3]) << ' '
+              << q.cancel(timers[3]) << '\n';
+    q.arm(timers[4], 2);
+    std::cout << "size: " << q.size() << " far: " << q.far_size()
+              << " D armed: " << timers[3].armed() << '\n';
+
+    std::cout << "\nadvance(10):\n";
+    std::cout << '\n' << q.advance(10, print) << " expired, far: "
+              << q.far_size() << " next: " << *q.next_deadline() << '\n';
+
+    std::cout << "\nadvance(30), F re-arms itself once at 25:\n";
+    bool rearmed{};
+    std::cout << '\n' << q.advance(30, [&](TestTimer &t){
+        print(t);
+        if (t.name == 'F' && !rearmed) {
+            rearmed = true;
+            q.arm(t, 25);
+        }
+    }) << " expired\n";
+
+    std::cout << "\nadvance(1000000) on an empty queue, arm A in the past:\n";
+    q.advance(1000000, print);
+    q.arm(timers[0], 50);
+    std::cout << "now: " << q.now() << " A@" << timers[0].deadline() << '\n';
+    q.advance(1000001, print);
+    std::cout << "\nempty: " << q.empty() << '\n';
+
+    return 0;
+}